@@ -13,8 +13,25 @@
 #endif
 */
 
+#define POLY_MAX_VERTS 32   // largest outline fillPolygon() accepts
+
+// drawRLEBitmap() data is a sequence of runs, each a header word holding a
+// pixel count of 1..32767.  With RLE_LITERAL set, that many RGB565 pixels
+// follow; otherwise one pixel follows and is repeated.  A header with a
+// count of 0 ends the image.  host/png2rle.py converts PNG images to this
+// format.
+#define RLE_LITERAL 0x8000
+
 #define swap(a, b) {int t = a; a = b; b = t; }
 
+// Every primitive draws only inside clipRect (inclusive bounds).  It starts
+// out as the whole screen; setClipRect() narrows it to a viewport.
+typedef struct {
+  int x0, y0, x1, y1;
+} ClipRect;
+
+extern ClipRect clipRect;
+
 // class Adafruit_GFX : public Print {
 
 // public:
@@ -44,18 +61,27 @@
     void fillCircleHelper(int x0, int y0, int r, unsigned char cornername, int delta, unsigned int color);
     void drawTriangle(int x0, int y0, int x1, int y1, int x2, int y2, unsigned int color);
     void fillTriangle(int x0, int y0, int x1, int y1, int x2, int y2, unsigned int color);
+    void fillPolygon(const int *xs, const int *ys, int n, unsigned int color);
     void drawRoundRect(int x0, int y0, int w, int h, int radius, unsigned int color);
     void fillRoundRect(int x0, int y0, int w, int h, int radius, unsigned int color);
+    void fillEllipse(int x0, int y0, int rx, int ry, unsigned int color);
     void drawBitmap(int x, int y, const unsigned char *bitmap, int w, int h, unsigned int color);
-//    void drawBitmap(int x, int y, const unsigned char *bitmap, int w, int h, unsigned int color, unsigned int bg);
+    void drawBitmapBg(int x, int y, const unsigned char *bitmap, int w, int h, unsigned int color, unsigned int bg);
     void drawXBitmap(int x, int y, const unsigned char *bitmap, int w, int h, unsigned int color);
+    void drawRGBBitmap(int x, int y, const unsigned short *pixels, int w, int h);
+    void drawRLEBitmap(int x, int y, const unsigned short *rle, int w, int h);
     void drawChar(int x, int y, unsigned char c, unsigned int color, unsigned int bg, unsigned char size);
+    // The five font columns of c, bit j of each being row j; the sixth
+    // column of a character cell is blank
+    const unsigned char *glyphColumns(unsigned char c);
     void setCursor(int x, int y);
 //    void setTextColor(unsigned int c);
     void setTextColor(unsigned int c, unsigned int bg);
     void setTextSize(unsigned char s);
     void setTextWrap(char w);
-//    void setRotation(unsigned char r);
+    void setRotation(unsigned char r);
+    void setClipRect(int x, int y, int w, int h);
+    void clearClipRect(void);
 
 #if ARDUINO >= 100
   virtual size_t write(unsigned char);
@@ -0,0 +1,351 @@
+//*****************************************************************************
+//
+// framebuffer.c
+//
+// All drawing lands in an SRAM copy of the panel.  Every fill records the
+// rectangle it touched; overlapping or adjacent rectangles are merged so the
+// dirty set stays disjoint and displayFlush() sends each pixel at most once,
+// one window burst per region.
+//
+// With SSD1351_DOUBLEBUFFER the dirty regions only bound the search.  The
+// flush walks each of their rows a 32-bit word (two pixels) at a time
+// against the front copy of the glass and sends just the runs of words that
+// differ, so a frame redrawn from scratch costs no more than its changes.
+// Each run goes out as a one-row window; when the next row changes over the
+// same columns the window shadow in setAddrWindow() lines up and no window
+// commands are sent for it.
+//
+// With SSD1351_INDEXED a row holds 4- or 8-bit palette indices, so a word
+// covers eight or four pixels.  Rows are expanded through the palette into
+// a line buffer on their way out; nothing else sees RGB565.
+//
+//*****************************************************************************
+
+#include <string.h>
+
+#include "Adafruit_SSD1351.h"
+#include "framebuffer.h"
+#include "rgb565.h"
+
+#ifdef SSD1351_FRAMEBUFFER
+
+typedef struct {
+    int x0, y0, x1, y1;     // inclusive bounds
+} DirtyRect;
+
+// A row can be read as pixels or as 32-bit words of FB_WORD_PIXELS each.
+// At 4 bits the left pixel of each byte is in its high nibble.
+typedef union {
+#ifdef SSD1351_INDEXED
+    unsigned char idx[SSD1351WIDTH * FB_BPP / 8];
+#else
+    unsigned short px[SSD1351WIDTH];
+#endif
+    unsigned int words[SSD1351WIDTH / FB_WORD_PIXELS];
+} FrameRow;
+
+static FrameRow frame[SSD1351HEIGHT];
+#ifdef SSD1351_DOUBLEBUFFER
+static FrameRow front[SSD1351HEIGHT];
+static unsigned char frontValid;
+#endif
+static DirtyRect dirty[FB_MAX_DIRTY];
+static int numDirty;
+static unsigned long drawnBytes;
+
+#ifdef SSD1351_INDEXED
+static unsigned short palette[FB_PALETTE_SIZE] = {
+    0x0000, 0x001F, 0x07E0, 0x07FF, 0xF800, 0xF81F, 0xFFE0, 0xFFFF,
+    0x39E7, 0x000F, 0x03E0, 0x03EF, 0x7800, 0x780F, 0x7BE0, 0x7BEF
+};
+static unsigned short line[SSD1351WIDTH];
+
+// displayMatchColor()'s last answer; images repeat colours in long runs
+static unsigned int matchColor = 0x10000, matchIndex;
+#endif
+
+FrameStats frameStats;
+
+static int touches(const DirtyRect *r, int x0, int y0, int x1, int y1) {
+    return x0 <= r->x1 + 1 && x1 + 1 >= r->x0 &&
+           y0 <= r->y1 + 1 && y1 + 1 >= r->y0;
+}
+
+static void removeDirty(int i) {
+    dirty[i] = dirty[--numDirty];
+}
+
+static void markDirty(int x0, int y0, int x1, int y1) {
+    int i, best;
+    long area, grow, bestGrow;
+
+    // Absorb every region the new one touches.  The grown rectangle may now
+    // reach regions it missed before, so rescan until nothing merges.
+    i = 0;
+    while (i < numDirty) {
+        if (touches(&dirty[i], x0, y0, x1, y1)) {
+            if (dirty[i].x0 < x0) x0 = dirty[i].x0;
+            if (dirty[i].y0 < y0) y0 = dirty[i].y0;
+            if (dirty[i].x1 > x1) x1 = dirty[i].x1;
+            if (dirty[i].y1 > y1) y1 = dirty[i].y1;
+            removeDirty(i);
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+
+    if (numDirty == FB_MAX_DIRTY) {
+        // No room left: fold into the region whose bounding box grows least
+        best = 0;
+        bestGrow = -1;
+        for (i = 0; i < numDirty; i++) {
+            int ux0 = dirty[i].x0 < x0 ? dirty[i].x0 : x0;
+            int uy0 = dirty[i].y0 < y0 ? dirty[i].y0 : y0;
+            int ux1 = dirty[i].x1 > x1 ? dirty[i].x1 : x1;
+            int uy1 = dirty[i].y1 > y1 ? dirty[i].y1 : y1;
+
+            area = (long)(dirty[i].x1 - dirty[i].x0 + 1) * (dirty[i].y1 - dirty[i].y0 + 1);
+            grow = (long)(ux1 - ux0 + 1) * (uy1 - uy0 + 1) - area;
+            if (bestGrow < 0 || grow < bestGrow) {
+                best = i;
+                bestGrow = grow;
+            }
+        }
+        if (dirty[best].x0 < x0) x0 = dirty[best].x0;
+        if (dirty[best].y0 < y0) y0 = dirty[best].y0;
+        if (dirty[best].x1 > x1) x1 = dirty[best].x1;
+        if (dirty[best].y1 > y1) y1 = dirty[best].y1;
+        removeDirty(best);
+        markDirty(x0, y0, x1, y1);
+        return;
+    }
+
+    dirty[numDirty].x0 = x0;
+    dirty[numDirty].y0 = y0;
+    dirty[numDirty].x1 = x1;
+    dirty[numDirty].y1 = y1;
+    numDirty++;
+}
+
+#ifdef SSD1351_INDEXED
+// Set w indices of a row from x on
+static void fillIndices(unsigned char *row, int x, int w, unsigned int index) {
+#if FB_BPP == 8
+    memset(row + x, index, w);
+#else
+    if (x & 1) {
+        row[x / 2] = (row[x / 2] & 0xF0) | index;
+        x++;
+        w--;
+    }
+    memset(row + x / 2, index * 0x11, w / 2);
+    if (w & 1)
+        row[(x + w - 1) / 2] = (row[(x + w - 1) / 2] & 0x0F) | index << 4;
+#endif
+}
+#endif
+
+void fbFillRect(int x, int y, int w, int h, unsigned int color) {
+    int j;
+
+    // fillRect() has clipped already; this keeps SRAM safe for other callers
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > SSD1351WIDTH) w = SSD1351WIDTH - x;
+    if (y + h > SSD1351HEIGHT) h = SSD1351HEIGHT - y;
+    if (w <= 0 || h <= 0)
+        return;
+
+#ifdef SSD1351_INDEXED
+    color &= FB_PALETTE_SIZE - 1;
+    for (j = 0; j < h; j++)
+        fillIndices(frame[y + j].idx, x, w, color);
+#else
+    for (j = 0; j < h; j++)
+        fill16(&frame[y + j].px[x], color, w);
+#endif
+
+    drawnBytes += FB_WINDOW_BYTES + 2UL * w * h;
+    markDirty(x, y, x + w - 1, y + h - 1);
+}
+
+unsigned int fbGetPixel(int x, int y) {
+#if FB_BPP == 4
+    return x & 1 ? frame[y].idx[x / 2] & 15 : frame[y].idx[x / 2] >> 4;
+#elif FB_BPP == 8
+    return frame[y].idx[x];
+#else
+    return frame[y].px[x];
+#endif
+}
+
+// Pixels x0 .. x0 + n - 1 of row y as RGB565, ready for writePixels()
+static const unsigned short *rowPixels(int y, int x0, int n) {
+#ifdef SSD1351_INDEXED
+    const unsigned char *p = frame[y].idx;
+    int i = 0;
+
+#if FB_BPP == 8
+    for (; i < n; i++)
+        line[i] = palette[p[x0 + i]];
+#else
+    if (x0 & 1)
+        line[i++] = palette[p[x0 / 2] & 15];
+    for (; i + 1 < n; i += 2) {
+        unsigned int b = p[(x0 + i) / 2];
+
+        line[i] = palette[b >> 4];
+        line[i + 1] = palette[b & 15];
+    }
+    if (i < n)
+        line[i] = palette[p[(x0 + i) / 2] >> 4];
+#endif
+    return line;
+#else
+    (void)n;
+    return &frame[y].px[x0];
+#endif
+}
+
+#ifdef SSD1351_DOUBLEBUFFER
+void displayInvalidate(void) {
+    frontValid = 0;
+}
+
+// Send the words of rows y0..y1 between words w0 and w1 that differ from
+// the front copy, and bring the front copy up to date
+static void sendChanges(int w0, int w1, int y0, int y1, int *started) {
+    const unsigned int *b;
+    unsigned int *f;
+    int i, k, end, x, n, y;
+
+    for (y = y0; y <= y1; y++) {
+        b = frame[y].words;
+        f = front[y].words;
+        i = w0;
+        for (;;) {
+            while (i <= w1 && b[i] == f[i])
+                i++;
+            if (i > w1)
+                break;
+
+            // extend the run over differing words and short gaps
+            for (end = k = i; k <= w1 && k - end <= FB_DIFF_GAP; k++)
+                if (b[k] != f[k])
+                    end = k;
+
+            if (!*started) {
+                startWrite();
+                *started = 1;
+            }
+            x = FB_WORD_PIXELS * i;
+            n = FB_WORD_PIXELS * (end - i + 1);
+            setAddrWindow(x, y, n, 1);
+            writePixels(rowPixels(y, x, n), n);
+            for (k = i; k <= end; k++)
+                f[k] = b[k];
+            i = end + 1;
+        }
+    }
+}
+#endif
+
+unsigned long displayFlush(void) {
+    unsigned long before = oledStats.bytes;
+    int i, y;
+
+#ifdef SSD1351_DOUBLEBUFFER
+    if (frontValid) {
+        int started = 0;
+
+        for (i = 0; i < numDirty; i++)
+            sendChanges(dirty[i].x0 / FB_WORD_PIXELS, dirty[i].x1 / FB_WORD_PIXELS,
+                        dirty[i].y0, dirty[i].y1, &started);
+        if (started)
+            endWrite();
+        numDirty = 0;
+    } else {
+        // nothing is known about the glass: send the whole frame
+        numDirty = 0;
+        markDirty(0, 0, SSD1351WIDTH - 1, SSD1351HEIGHT - 1);
+        for (y = 0; y < SSD1351HEIGHT; y++)
+            front[y] = frame[y];
+        frontValid = 1;
+    }
+#endif
+
+    if (numDirty) {
+        startWrite();
+        for (i = 0; i < numDirty; i++) {
+            DirtyRect *r = &dirty[i];
+            int w = r->x1 - r->x0 + 1;
+
+            setAddrWindow(r->x0, r->y0, w, r->y1 - r->y0 + 1);
+            for (y = r->y0; y <= r->y1; y++)
+                writePixels(rowPixels(y, r->x0, w), w);
+        }
+        endWrite();
+        numDirty = 0;
+    }
+
+    frameStats.drawnBytes = drawnBytes;
+    frameStats.sentBytes = oledStats.bytes - before;
+    drawnBytes = 0;
+
+    return frameStats.sentBytes;
+}
+
+#ifdef SSD1351_INDEXED
+void displaySetPalette(const unsigned short *colors, int first, int n) {
+    int i;
+
+    for (i = 0; i < n; i++)
+        if (first + i >= 0 && first + i < FB_PALETTE_SIZE)
+            palette[first + i] = colors[i];
+    matchColor = 0x10000;
+
+    // any pixel may use a changed entry
+    markDirty(0, 0, SSD1351WIDTH - 1, SSD1351HEIGHT - 1);
+#ifdef SSD1351_DOUBLEBUFFER
+    frontValid = 0;
+#endif
+}
+
+unsigned int displayPaletteColor(unsigned int index) {
+    return palette[index & (FB_PALETTE_SIZE - 1)];
+}
+
+// Squared distance between two RGB565 colours, red and blue scaled to six
+// bits like green
+static long distance(unsigned int a, unsigned int b) {
+    long dr = (long)((a >> 10) & 0x3E) - ((b >> 10) & 0x3E);
+    long dg = (long)((a >> 5) & 0x3F) - ((b >> 5) & 0x3F);
+    long db = (long)((a << 1) & 0x3E) - ((b << 1) & 0x3E);
+
+    return dr * dr + dg * dg + db * db;
+}
+
+unsigned int displayMatchColor(unsigned int color) {
+    long d, best;
+    unsigned int i;
+
+    color &= 0xFFFF;
+    if (color == matchColor)
+        return matchIndex;
+
+    matchIndex = 0;
+    best = distance(color, palette[0]);
+    for (i = 1; i < FB_PALETTE_SIZE && best; i++) {
+        d = distance(color, palette[i]);
+        if (d < best) {
+            best = d;
+            matchIndex = i;
+        }
+    }
+    matchColor = color;
+    return matchIndex;
+}
+#endif
+
+#endif // SSD1351_FRAMEBUFFER
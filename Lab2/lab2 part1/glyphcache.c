@@ -0,0 +1,83 @@
+//*****************************************************************************
+//
+// glyphcache.c
+//
+// The cache is small enough that a linear scan beats anything cleverer:
+// each lookup compares at most GLYPH_CACHE_ENTRIES keys, and recency is a
+// stamp from a running counter, so the victim is the entry with the
+// oldest stamp.
+//
+//*****************************************************************************
+
+#include "Adafruit_SSD1351.h"
+#include "glyphcache.h"
+
+#ifdef SSD1351_GLYPHCACHE
+
+typedef struct {
+    unsigned short color;
+    unsigned short bg;
+    unsigned char c;
+    unsigned char valid;
+    unsigned long stamp;
+    unsigned short pixels[GLYPH_PIXELS];
+} GlyphEntry;
+
+static GlyphEntry entries[GLYPH_CACHE_ENTRIES];
+static unsigned long useCount;
+
+GlyphCacheStats glyphCacheStats;
+
+const unsigned short *glyphCacheFind(unsigned char c, unsigned int color, unsigned int bg) {
+    int i;
+
+    for (i = 0; i < GLYPH_CACHE_ENTRIES; i++) {
+        GlyphEntry *e = &entries[i];
+
+        if (e->valid && e->c == c && e->color == (unsigned short)color &&
+                e->bg == (unsigned short)bg) {
+            e->stamp = ++useCount;
+            glyphCacheStats.hits++;
+            return e->pixels;
+        }
+    }
+    glyphCacheStats.misses++;
+    return 0;
+}
+
+unsigned short *glyphCacheInsert(unsigned char c, unsigned int color, unsigned int bg) {
+    GlyphEntry *victim = &entries[0];
+    int i;
+
+    for (i = 0; i < GLYPH_CACHE_ENTRIES; i++) {
+        if (!entries[i].valid) {
+            victim = &entries[i];
+            break;
+        }
+        if (entries[i].stamp < victim->stamp)
+            victim = &entries[i];
+    }
+
+    if (victim->valid) {
+        glyphCacheStats.evictions++;
+    } else {
+        glyphCacheStats.bytes += sizeof(GlyphEntry);
+    }
+
+    victim->c = c;
+    victim->color = color;
+    victim->bg = bg;
+    victim->valid = 1;
+    victim->stamp = ++useCount;
+    return victim->pixels;
+}
+
+void glyphCacheClear(void) {
+    int i;
+
+    for (i = 0; i < GLYPH_CACHE_ENTRIES; i++)
+        entries[i].valid = 0;
+    glyphCacheStats.bytes = 0;
+}
+
+#endif // SSD1351_GLYPHCACHE
@@ -0,0 +1,45 @@
+//*****************************************************************************
+//
+// glyphcache.h
+//
+// LRU cache of pre-expanded RGB565 glyph images for drawChar().  Enabled by
+// defining SSD1351_GLYPHCACHE in Adafruit_SSD1351.h.
+//
+// Entries hold the unscaled 6x8 image of a character in one fg/bg color
+// pair; larger text sizes replicate the cached pixels while streaming, so
+// one entry serves every size.
+//
+//*****************************************************************************
+
+#ifndef _GLYPHCACHE_H
+#define _GLYPHCACHE_H
+
+#include "Adafruit_SSD1351.h"
+
+#define GLYPH_CACHE_ENTRIES 16
+#define GLYPH_PIXELS        (6 * 8)
+
+typedef struct {
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;    // misses that replaced a live entry
+    unsigned long bytes;        // RAM held by the entries in use
+} GlyphCacheStats;
+
+#ifdef SSD1351_GLYPHCACHE
+
+extern GlyphCacheStats glyphCacheStats;
+
+// Cached image for the key, or 0 on a miss
+const unsigned short *glyphCacheFind(unsigned char c, unsigned int color, unsigned int bg);
+
+// Claim the least recently used entry for the key; the caller fills in the
+// GLYPH_PIXELS pixels, row by row
+unsigned short *glyphCacheInsert(unsigned char c, unsigned int color, unsigned int bg);
+
+// Drop every entry (the counters are kept)
+void glyphCacheClear(void);
+
+#endif // SSD1351_GLYPHCACHE
+
+#endif // _GLYPHCACHE_H
@@ -75,6 +75,10 @@
 
 #include "pin_mux_config.h"
 #include "Adafruit_GFX.h"
+
+// Uncomment to run the graphics benchmark in test.h instead of the demo
+// #define GFX_BENCHMARK
+
 #include "test.h"
 
 
@@ -221,7 +225,11 @@ void main()
     MAP_GPIOPinWrite(GPIOA0_BASE, OC, OC);
     Adafruit_Init();
 
+#ifdef GFX_BENCHMARK
+    benchmark();
+#else
     test();
+#endif
 
     MAP_SPICSDisable(GSPI_BASE);
 }
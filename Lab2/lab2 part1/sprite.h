@@ -0,0 +1,49 @@
+//*****************************************************************************
+//
+// sprite.h
+//
+// Moving RGB565 images over a fixed background.  The application moves a
+// sprite by changing its x and y (or hides it by clearing visible) and then
+// calls spriteFrame(), which redraws only the area each changed sprite
+// left and entered.  That area is composed in SRAM from the background and
+// every sprite over it and sent as a single window, so nothing is erased on
+// the glass first and nothing flickers.
+//
+// What shows where no sprite covers it is the restore policy set with
+// spriteBackground(): a solid colour, or a screen-sized image.
+//
+//*****************************************************************************
+
+#ifndef _SPRITE_H
+#define _SPRITE_H
+
+#define SPRITE_MAX      8           // sprites spriteAdd() accepts
+#define SPRITE_NO_KEY   0x10000     // key for a sprite with no transparent pixels
+
+typedef struct {
+    int x, y;                       // top left, in screen coordinates
+    int w, h;
+    const unsigned short *image;    // w x h RGB565 pixels, row by row
+    unsigned int key;               // pixels of this colour show what is behind
+    unsigned char visible;
+
+    // what spriteFrame() last put on the glass
+    int drawnX, drawnY;
+    unsigned char drawn;
+} Sprite;
+
+// Restore policy for uncovered pixels: image, when not 0, holds
+// width() x height() pixels, otherwise color is used.  Does not redraw.
+void spriteBackground(unsigned int color, const unsigned short *image);
+
+// Add a sprite on top of the others; it appears at the next spriteFrame().
+// Returns 0 if SPRITE_MAX sprites are in use already.
+int spriteAdd(Sprite *s);
+
+// Erase a sprite from the glass and forget it
+void spriteRemove(Sprite *s);
+
+// Bring the glass up to date with every sprite's position and visibility
+void spriteFrame(void);
+
+#endif // _SPRITE_H
@@ -0,0 +1,240 @@
+//*****************************************************************************
+//
+// stripbuffer.c
+//
+// Every band starts out as the frame background and has the recorded fills
+// and glyphs that cross it painted in order, so overdraw costs SRAM cycles
+// rather than SPI bytes.  A hash of each band's pixels is kept from the previous frame;
+// bands that come out identical are not sent again.
+//
+// A glyph is recorded whole and its font pixels expanded only for the rows
+// of the band being rendered, so text costs one op per character rather
+// than one per run of pixels.
+//
+// If a frame records more than STRIP_MAX_OPS ops, the frame so far is
+// rendered at that point and the remaining draws go straight to the panel,
+// which keeps the painter's order intact.  The band hashes are dropped so
+// the next frame is sent in full.
+//
+// The hashes describe what the panel shows, so anything else that reaches
+// the panel drops them too: a fill drawn directly outside a frame, and the
+// raw commands, remaps and goTo() writes in Adafruit_OLED.c.
+//
+//*****************************************************************************
+
+#include "Adafruit_GFX.h"
+#include "Adafruit_SSD1351.h"
+#include "stripbuffer.h"
+#include "rgb565.h"
+
+#ifdef SSD1351_STRIPBUFFER
+
+#define NUM_BANDS   ((SSD1351HEIGHT + STRIP_BAND_HEIGHT - 1) / STRIP_BAND_HEIGHT)
+
+#if SSD1351WIDTH > 128
+  #error "StripOp keeps x in seven bits."
+#endif
+
+// An op is 8 bytes.  The panel is at most 128 pixels wide, so x fits in
+// seven bits and the top one marks a glyph.
+#define OP_GLYPH    0x80
+#define OP_X        0x7F
+
+typedef struct {
+    unsigned char x, y;
+    unsigned char w, h;     // fill size, or glyph character and text size
+    unsigned short color;
+    unsigned short bg;      // glyph background; unused by fills
+} StripOp;
+
+static unsigned short strip[STRIP_BAND_HEIGHT][SSD1351WIDTH];
+static StripOp ops[STRIP_MAX_OPS];
+static int numOps;
+static unsigned long bandHash[NUM_BANDS];
+static unsigned char hashValid;
+static unsigned char recording;
+static unsigned short background;
+static unsigned long drawnBytes;
+
+FrameStats frameStats;
+
+void stripBegin(unsigned int bg) {
+    numOps = 0;
+    background = bg;
+    recording = 1;
+    drawnBytes = 0;
+}
+
+void stripInvalidate(void) {
+    hashValid = 0;
+}
+
+// The next free op, or 0 when the frame is out of room: the frame so far
+// is then put on the glass and the rest of it draws directly
+static StripOp *stripPut(void) {
+    if (numOps == STRIP_MAX_OPS) {
+        stripEnd();
+        hashValid = 0;
+        return 0;
+    }
+    return &ops[numOps++];
+}
+
+int stripFillRect(int x, int y, int w, int h, unsigned int color) {
+    StripOp *op;
+
+    if (!recording) {
+        // drawn directly, over whatever the last frame left
+        hashValid = 0;
+        return 0;
+    }
+
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (w <= 0 || h <= 0)
+        return 1;
+
+    op = stripPut();
+    if (!op)
+        return 0;
+    op->x = x;
+    op->y = y;
+    op->w = w;
+    op->h = h;
+    op->color = color;
+
+    // 7 bytes of window setup plus the pixels, had it been sent directly
+    drawnBytes += 7 + 2UL * w * h;
+    return 1;
+}
+
+int stripGlyph(int x, int y, unsigned char c, unsigned int color,
+               unsigned int bg, unsigned char size) {
+    const unsigned char *font;
+    unsigned char line;
+    StripOp *op;
+    int i, j, start;
+
+    if (!recording) {
+        hashValid = 0;
+        return 0;
+    }
+
+    op = stripPut();
+    if (!op)
+        return 0;
+    op->x = x | OP_GLYPH;
+    op->y = y;
+    op->w = c;
+    op->h = size;
+    op->color = color;
+    op->bg = bg;
+
+    // the fills drawChar() would have sent directly, one per run
+    font = glyphColumns(c);
+    for (i = 0; i < 6; i++) {
+        line = i < 5 ? font[i] : 0;
+        for (j = 0; j < 8; j = start) {
+            start = j;
+            while (start < 8 && ((line >> start) & 1) == ((line >> j) & 1))
+                start++;
+            if (((line >> j) & 1) || bg != color)
+                drawnBytes += 7 + 2UL * size * size * (start - j);
+        }
+    }
+    return 1;
+}
+
+// The rows of a glyph that fall in the band; clear pixels are left alone
+// when the glyph is transparent (bg == color)
+static void renderGlyph(const StripOp *op, int y0, int rows) {
+    const unsigned char *font = glyphColumns(op->w);
+    int x = op->x & OP_X;
+    int size = op->h;
+    int top = op->y > y0 ? op->y : y0;
+    int bottom = op->y + 8 * size < y0 + rows ? op->y + 8 * size : y0 + rows;
+    unsigned char line;
+    int i, y, bit;
+
+    for (y = top; y < bottom; y++) {
+        bit = (y - op->y) / size;
+        for (i = 0; i < 6; i++) {
+            line = i < 5 ? font[i] : 0;
+            if ((line >> bit) & 1)
+                fill16(&strip[y - y0][x + i * size], op->color, size);
+            else if (op->bg != op->color)
+                fill16(&strip[y - y0][x + i * size], op->bg, size);
+        }
+    }
+}
+
+static void renderBand(int y0, int rows) {
+    int i, y;
+
+    fill16(&strip[0][0], background, (unsigned long)rows * SSD1351WIDTH);
+
+    for (i = 0; i < numOps; i++) {
+        const StripOp *op = &ops[i];
+        int top, bottom;
+
+        if (op->x & OP_GLYPH) {
+            renderGlyph(op, y0, rows);
+            continue;
+        }
+        top = op->y > y0 ? op->y : y0;
+        bottom = op->y + op->h < y0 + rows ? op->y + op->h : y0 + rows;
+        for (y = top; y < bottom; y++)
+            fill16(&strip[y - y0][op->x], op->color, op->w);
+    }
+}
+
+// FNV-1a over the band's pixels
+static unsigned long hashBand(int rows) {
+    const unsigned short *p = &strip[0][0];
+    unsigned long h = 2166136261UL;
+    int n = rows * SSD1351WIDTH;
+
+    while (n--) {
+        h = (h ^ *p++) * 16777619UL;
+    }
+    return h;
+}
+
+unsigned long stripEnd(void) {
+    unsigned long before = oledStats.bytes;
+    unsigned long h;
+    int band, y0, rows, started = 0;
+
+    if (!recording)
+        return 0;
+    recording = 0;
+
+    for (band = 0; band < NUM_BANDS; band++) {
+        y0 = band * STRIP_BAND_HEIGHT;
+        rows = SSD1351HEIGHT - y0 < STRIP_BAND_HEIGHT ? SSD1351HEIGHT - y0 : STRIP_BAND_HEIGHT;
+
+        renderBand(y0, rows);
+        h = hashBand(rows);
+        if (hashValid && h == bandHash[band])
+            continue;
+        bandHash[band] = h;
+
+        if (!started) {
+            startWrite();
+            started = 1;
+        }
+        setAddrWindow(0, y0, SSD1351WIDTH, rows);
+        writePixels(&strip[0][0], (unsigned long)rows * SSD1351WIDTH);
+    }
+    if (started)
+        endWrite();
+    hashValid = 1;
+    numOps = 0;
+
+    frameStats.drawnBytes = drawnBytes;
+    frameStats.sentBytes = oledStats.bytes - before;
+
+    return frameStats.sentBytes;
+}
+
+#endif // SSD1351_STRIPBUFFER
@@ -32,12 +32,14 @@ float p = 3.1415926;
 //*****************************************************************************
 //  function delays 3*ulCount cycles
 void delay(unsigned long ulCount){
+#ifndef GFX_BENCHMARK
 	int i;
 
   do{
     ulCount--;
 		for (i=0; i< 65535; i++) ;
 	}while(ulCount);
+#endif
 }
 
 
@@ -316,3 +318,124 @@ void test() {
         testtriangles();
     }
 }
+
+/**************************************************************************/
+/* Benchmark: define GFX_BENCHMARK to compile the delays above out and call
+*  benchmark() instead of test().  Each workload prints one CSV line with
+*  the SPI traffic it generated (from oledStats), the time that traffic
+*  needs on the wire at each of BENCH_BIT_RATES, and the CPU cycles it
+*  took as read from the Cortex-M4 DWT cycle counter.  Host builds define
+*  BENCH_HOST, which reports "-" for cycles, and their own BENCH_PRINT and
+*  BENCH_EOL.
+*/
+#ifdef GFX_BENCHMARK
+
+#ifndef BENCH_BIT_RATES
+#define BENCH_BIT_RATES     100000, 400000
+#endif
+
+#ifndef BENCH_PRINT
+#define BENCH_PRINT         Report
+#define BENCH_EOL           "\n\r"
+#endif
+
+#ifndef BENCH_HOST
+#define DEMCR               (*(volatile unsigned long *)0xE000EDFC)
+#define DWT_CTRL            (*(volatile unsigned long *)0xE0001000)
+#define DWT_CYCCNT          (*(volatile unsigned long *)0xE0001004)
+#endif
+
+static const unsigned long benchRates[] = { BENCH_BIT_RATES };
+
+static void benchHlines(void) { testHlines(); }
+static void benchVlines(void) { testVlines(); }
+static void benchLines(void) { testlines(CYAN); }
+static void benchFastLines(void) { testfastlines(CYAN, RED); }
+static void benchDrawRects(void) { testdrawrects(YELLOW); }
+static void benchFillRects(void) { testfillrects(WHITE, RED); }
+static void benchFillCircles(void) { testfillcircles(5, BLUE); }
+static void benchDrawCircles(void) { testdrawcircles(10, WHITE); }
+static void benchTriangles(void) { testtriangles(); }
+static void benchRoundRects(void) { testroundrects(); }
+static void benchPattern(void) { lcdTestPattern(); }
+
+static void benchText(void) {
+    int index, cx, cy;
+
+    fillScreen(BLACK);
+    for (cx = 0, cy = 0, index = 0; index < 255; index++, cx+=6) {
+        drawChar(cx, cy, index, WHITE, BLACK, 1);
+        if (cx > 127) {
+            cx = 0;
+            cy += 8;
+        }
+    }
+}
+
+static const struct {
+    const char *name;
+    void (*run)(void);
+} benchWorkloads[] = {
+    { "hlines",       benchHlines },
+    { "vlines",       benchVlines },
+    { "lines",        benchLines },
+    { "fastlines",    benchFastLines },
+    { "drawrects",    benchDrawRects },
+    { "fillrects",    benchFillRects },
+    { "fillcircles",  benchFillCircles },
+    { "drawcircles",  benchDrawCircles },
+    { "triangles",    benchTriangles },
+    { "roundrects",   benchRoundRects },
+    { "testpattern",  benchPattern },
+    { "text",         benchText },
+};
+
+void benchmark(void) {
+    unsigned int i, r;
+    unsigned long bytes, commands, transactions;
+#ifndef BENCH_HOST
+    unsigned long cycles;
+
+    // enable the DWT cycle counter
+    DEMCR |= 0x01000000;
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= 1;
+#endif
+
+    BENCH_PRINT("workload,bytes,commands,transactions,cycles");
+    for (r = 0; r < sizeof(benchRates) / sizeof(benchRates[0]); r++)
+        BENCH_PRINT(",us_at_%lu", benchRates[r]);
+    BENCH_PRINT(BENCH_EOL);
+
+    for (i = 0; i < sizeof(benchWorkloads) / sizeof(benchWorkloads[0]); i++) {
+        bytes = oledStats.bytes;
+        commands = oledStats.commands;
+        transactions = oledStats.transactions;
+#ifndef BENCH_HOST
+        cycles = DWT_CYCCNT;
+#endif
+
+        benchWorkloads[i].run();
+
+#ifndef BENCH_HOST
+        cycles = DWT_CYCCNT - cycles;
+#endif
+        bytes = oledStats.bytes - bytes;
+        commands = oledStats.commands - commands;
+        transactions = oledStats.transactions - transactions;
+
+        BENCH_PRINT("%s,%lu,%lu,%lu,", benchWorkloads[i].name, bytes, commands, transactions);
+#ifndef BENCH_HOST
+        BENCH_PRINT("%lu", cycles);
+#else
+        BENCH_PRINT("-");
+#endif
+        // 8 clocks per byte; the bus idles between bytes only as long as
+        // the CPU takes to queue the next one, which cycles already covers
+        for (r = 0; r < sizeof(benchRates) / sizeof(benchRates[0]); r++)
+            BENCH_PRINT(",%lu", (unsigned long)((unsigned long long)bytes * 8 * 1000000 / benchRates[r]));
+        BENCH_PRINT(BENCH_EOL);
+    }
+}
+
+#endif // GFX_BENCHMARK
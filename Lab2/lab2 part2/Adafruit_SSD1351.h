@@ -47,6 +47,55 @@
   #error "RGB and BGR can not both be defined for SSD1351_COLORODER."
 #endif
 
+// Uncomment to render into a 128x128 RGB565 framebuffer in SRAM (32 KB).
+// Drawing calls then only touch SRAM and displayFlush() sends the dirty
+// regions to the panel.
+// #define SSD1351_FRAMEBUFFER
+
+// Uncomment as well to keep a second copy of what is on the glass (another
+// 32 KB).  displayFlush() then compares the frame with it word by word and
+// sends only the spans that changed, however much of the frame was redrawn.
+// #define SSD1351_DOUBLEBUFFER
+
+#if defined SSD1351_DOUBLEBUFFER && !defined SSD1351_FRAMEBUFFER
+  #error "SSD1351_DOUBLEBUFFER needs SSD1351_FRAMEBUFFER."
+#endif
+
+// Uncomment as well to store palette indices instead of RGB565: 4 bits per
+// pixel (8 KB, 16 colours) or 8 (16 KB, 256 colours).  Every colour passed
+// to a drawing call is then an index, expanded through the palette as the
+// frame is sent (see framebuffer.h).
+// #define SSD1351_INDEXED 4
+
+#if defined SSD1351_INDEXED && !defined SSD1351_FRAMEBUFFER
+  #error "SSD1351_INDEXED needs SSD1351_FRAMEBUFFER."
+#endif
+#if defined SSD1351_INDEXED && SSD1351_INDEXED != 4 && SSD1351_INDEXED != 8
+  #error "SSD1351_INDEXED must be 4 or 8."
+#endif
+
+// Uncomment instead on RAM-constrained builds: frames are recorded as a list
+// of fills and glyphs between stripBegin() and stripEnd() and rendered a band
+// at a time through a small strip buffer (about 3.8 KB, see stripbuffer.h).
+// #define SSD1351_STRIPBUFFER
+
+#if defined SSD1351_FRAMEBUFFER && defined SSD1351_STRIPBUFFER
+  #error "SSD1351_FRAMEBUFFER and SSD1351_STRIPBUFFER can not both be defined."
+#endif
+
+// Uncomment to queue drawing as a list of ops that displayDrain() sends to
+// the panel later, from the idle loop or a timer interrupt, so drawing calls
+// never wait on SPI (about 1.3 KB, see displaylist.h).
+// #define SSD1351_DISPLAYLIST
+
+#if defined SSD1351_DISPLAYLIST && (defined SSD1351_FRAMEBUFFER || defined SSD1351_STRIPBUFFER)
+  #error "SSD1351_DISPLAYLIST can not be combined with a framebuffer or strip buffer."
+#endif
+
+// Uncomment to keep recently drawn opaque glyphs as ready-made RGB565
+// images (about 1.7 KB, see glyphcache.h).  Only used by unbuffered builds.
+// #define SSD1351_GLYPHCACHE
+
 // Timing Delays
 #define SSD1351_DELAYS_HWFILL	    (3)
 #define SSD1351_DELAYS_HWLINE       (1)
@@ -94,18 +143,29 @@ class Adafruit_SSD1351  : public virtual Adafruit_GFX {
   unsigned int Color565(unsigned char r, unsigned char g, unsigned char b);
 */
 
+  // SPI traffic counters, updated by every transfer to the panel
+  typedef struct {
+    unsigned long bytes;          // command and data bytes clocked out
+    unsigned long commands;       // command bytes among them
+    unsigned long transactions;   // chip select assertions
+    unsigned long pixels;         // pixels streamed by writeColor()/writePixels()
+  } OledStats;
+
+  extern OledStats oledStats;
+
   void Adafruit_Init(void);
   void Outstr (char * str);
 	
   // drawing primitives!
   void drawPixel(int x, int y, unsigned int color);
-  void fillRect(unsigned int x0, unsigned int y0, unsigned int w, unsigned int h, unsigned int color);
+  void fillRect(int x0, int y0, int w, int h, unsigned int color);
   void drawFastHLine(int x, int y, int w, unsigned int color);
   void drawFastVLine(int x, int y, int h, unsigned int color);
   void fillScreen(unsigned int fillcolor);
 
   void invert(char);
   // commands
+  void setRemap(unsigned char rotation);
   void begin(void);
   void goTo(int x, int y);
 
@@ -116,6 +176,14 @@ class Adafruit_SSD1351  : public virtual Adafruit_GFX {
   void writeData(unsigned char d);
   void writeCommand(unsigned char c);
 
+  // burst transfers: startWrite(), setAddrWindow(), any number of
+  // writeColor()/writePixels(), then endWrite()
+  void startWrite(void);
+  void endWrite(void);
+  void setAddrWindow(int x, int y, int w, int h);
+  void writeColor(unsigned int color, unsigned long len);
+  void writePixels(const unsigned short *colors, unsigned long len);
+
 
   void writeData_unsafe(unsigned int d);
 
@@ -0,0 +1,89 @@
+//*****************************************************************************
+//
+// framebuffer.h
+//
+// Optional SRAM framebuffer for the SSD1351 driver.  Enabled by defining
+// SSD1351_FRAMEBUFFER in Adafruit_SSD1351.h.
+//
+// With SSD1351_INDEXED the frame holds palette indices.  Colours given to
+// the drawing calls are indices too; RGB565 images are matched to the
+// closest palette entry as they are drawn.  Changing the palette recolours
+// everything drawn with the changed entries without touching the frame.
+//
+//*****************************************************************************
+
+#ifndef _FRAMEBUFFER_H
+#define _FRAMEBUFFER_H
+
+#include "Adafruit_SSD1351.h"
+
+// Dirty regions kept before new ones are folded into the closest existing one
+#define FB_MAX_DIRTY    8
+
+// Bytes sent by the SSD1351 window setup that precedes every direct draw
+// (SETCOLUMN + 2, SETROW + 2, WRITERAM)
+#define FB_WINDOW_BYTES 7
+
+#ifdef SSD1351_INDEXED
+#define FB_BPP          SSD1351_INDEXED
+#define FB_PALETTE_SIZE (1 << SSD1351_INDEXED)
+#else
+#define FB_BPP          16
+#endif
+
+// Pixels in each 32-bit word of a frame row
+#define FB_WORD_PIXELS  (32 / FB_BPP)
+
+// SSD1351_DOUBLEBUFFER: runs of this many unchanged words or fewer are sent
+// along with the changes around them, as long as resending them costs less
+// than opening a new window (one word of RGB565 pixels, none once indexed)
+#define FB_DIFF_GAP     (FB_WINDOW_BYTES / (2 * FB_WORD_PIXELS))
+
+#ifdef SSD1351_INDEXED
+// Default palette: the eight colours the labs' main.c files define, then
+// the same at half brightness with dark grey in place of a second black.
+// A 256-colour palette is black after those sixteen.
+enum {
+    PAL_BLACK, PAL_BLUE, PAL_GREEN, PAL_CYAN,
+    PAL_RED, PAL_MAGENTA, PAL_YELLOW, PAL_WHITE
+};
+#endif
+
+typedef struct {
+    unsigned long drawnBytes;   // bytes the draws would have cost sent directly
+    unsigned long sentBytes;    // bytes displayFlush() actually sent
+} FrameStats;
+
+#ifdef SSD1351_FRAMEBUFFER
+
+// Statistics for the most recent displayFlush()
+extern FrameStats frameStats;
+
+// x, y, w, h must already be clipped to the panel
+void fbFillRect(int x, int y, int w, int h, unsigned int color);
+unsigned int fbGetPixel(int x, int y);
+
+// Push every dirty region to the panel; returns the number of bytes sent
+unsigned long displayFlush(void);
+
+#ifdef SSD1351_INDEXED
+// Replace palette entries first .. first + n - 1 with RGB565 colours.  The
+// whole frame is resent, in the new colours, by the next displayFlush().
+void displaySetPalette(const unsigned short *colors, int first, int n);
+
+// The RGB565 colour of a palette entry
+unsigned int displayPaletteColor(unsigned int index);
+
+// The palette entry closest to an RGB565 colour
+unsigned int displayMatchColor(unsigned int color);
+#endif
+
+#ifdef SSD1351_DOUBLEBUFFER
+// Forget what is on the glass, so the next displayFlush() sends the whole
+// frame.  Needed after anything other than displayFlush() writes the panel.
+void displayInvalidate(void);
+#endif
+
+#endif // SSD1351_FRAMEBUFFER
+
+#endif // _FRAMEBUFFER_H
@@ -30,6 +30,7 @@
 
 #include "pin_mux_config.h"
 #include "Adafruit_GFX.h"
+#include "sprite.h"
 
 
 //*****************************************************************************
@@ -54,6 +55,8 @@
 #define YELLOW          0xFFE0
 #define WHITE           0xFFFF
 
+#define BALL_SIZE       5
+
 #define OC  0x80
 #define RETERR_IF_TRUE(condition) {if(condition) return FAILURE;}
 #define RET_IF_ERR(Func)          {int iRetVal = (Func); \
@@ -202,9 +205,26 @@ void main()
     int cx = 64, cy = 64; //  start with middle
     int lastx = 64, lasty = 64;
     unsigned char x = 0x05, y = 0x03, xVal, yVal;
+    // the pixels fillCircle(cx, cy, 2, CYAN) sets; the black corners are
+    // transparent
+    static const unsigned short ballImage[BALL_SIZE * BALL_SIZE] = {
+        BLACK, CYAN,  CYAN,  CYAN,  BLACK,
+        CYAN,  CYAN,  CYAN,  CYAN,  CYAN,
+        CYAN,  CYAN,  CYAN,  CYAN,  CYAN,
+        CYAN,  CYAN,  CYAN,  CYAN,  CYAN,
+        BLACK, CYAN,  CYAN,  CYAN,  BLACK,
+    };
+    static Sprite ball = {
+        .w = BALL_SIZE, .h = BALL_SIZE, .image = ballImage,
+        .key = BLACK, .visible = 1,
+    };
     Adafruit_Init();
     fillScreen(BLACK);
-    fillCircle(cx, cy, 2, CYAN);
+    spriteBackground(BLACK, 0);
+    ball.x = cx - BALL_SIZE / 2;
+    ball.y = cy - BALL_SIZE / 2;
+    spriteAdd(&ball);
+    spriteFrame();
     while(FOREVER)
     {
         //
@@ -243,10 +263,12 @@ void main()
         cy = cy >= 123 ? 123 : cy;
         cy = cy <= 4 ? 4 : cy;
 
-        //  move if coordinates changed
+        //  move if coordinates changed: one window covering where the
+        //  ball was and where it is now
         if (lastx != cx || lasty != cy) {
-            fillCircle(lastx, lasty, 2, BLACK); // clear the circle
-            fillCircle(cx, cy, 2, CYAN); // draw the new one
+            ball.x = cx - BALL_SIZE / 2;
+            ball.y = cy - BALL_SIZE / 2;
+            spriteFrame();
         }
 
         lastx = cx;
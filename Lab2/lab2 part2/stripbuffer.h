@@ -0,0 +1,62 @@
+//*****************************************************************************
+//
+// stripbuffer.h
+//
+// Banded renderer for builds that cannot spare a full framebuffer.  Enabled
+// by defining SSD1351_STRIPBUFFER in Adafruit_SSD1351.h.
+//
+// Draw calls between stripBegin() and stripEnd() are recorded as a list of
+// fills and glyphs.  stripEnd() replays the list into a STRIP_BAND_HEIGHT-row
+// strip one band at a time and pushes each band that changed since the previous
+// frame with a single window write.  Outside a frame the primitives draw
+// straight to the panel as usual.
+//
+// RAM: 128 x STRIP_BAND_HEIGHT x 2 bytes of strip, 8 bytes per recorded op
+// and 4 bytes per band of change tracking, which has to stay under 4 KB
+// (3.8 KB as configured).
+//
+// Each fill and each character is one op, whatever its size.  A screen of
+// size 1 text is 21 x 16 = 336 characters, which is STRIP_MAX_OPS; the
+// 4-row strip is what pays for that many ops.  Past the budget the rest of
+// the frame still comes out right, but is drawn directly and sent in full.
+//
+//*****************************************************************************
+
+#ifndef _STRIPBUFFER_H
+#define _STRIPBUFFER_H
+
+#include "Adafruit_SSD1351.h"
+#include "framebuffer.h"
+
+#define STRIP_BAND_HEIGHT   4
+#define STRIP_MAX_OPS       336
+
+#ifdef SSD1351_STRIPBUFFER
+
+// Statistics for the most recent stripEnd()
+extern FrameStats frameStats;
+
+// Start recording a frame whose uncovered pixels are background
+void stripBegin(unsigned int background);
+
+// Render the recorded frame; returns the number of bytes sent
+unsigned long stripEnd(void);
+
+// Forget what the last frame sent, so the next one is sent in full.  Call
+// after changing the panel behind the renderer's back (scrolling, remapping
+// or writing GRAM directly); the library's own commands already do.
+void stripInvalidate(void);
+
+// Called by the primitives with bounds already clamped to the panel's far
+// edges; returns 0 when no frame is being recorded and the caller should
+// draw directly, which also drops the band hashes
+int stripFillRect(int x, int y, int w, int h, unsigned int color);
+
+// Called by drawChar() for a glyph that lies wholly inside the panel; same
+// return as stripFillRect()
+int stripGlyph(int x, int y, unsigned char c, unsigned int color,
+               unsigned int bg, unsigned char size);
+
+#endif // SSD1351_STRIPBUFFER
+
+#endif // _STRIPBUFFER_H
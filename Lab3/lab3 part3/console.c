@@ -0,0 +1,115 @@
+//*****************************************************************************
+//
+// console.c
+//
+// The SSD1351 shows GRAM row (startLine + y) % 128 at glass row y, so text
+// line n of the console lives at GRAM row startLine + 8n.  Scrolling by one
+// line advances startLine by 8: the old top line wraps around to become the
+// new input line and is cleared, and the old input line becomes the last
+// history line.  Only the GRAM rows that change are ever written.
+//
+//*****************************************************************************
+
+#include "Adafruit_GFX.h"
+#include "Adafruit_SSD1351.h"
+#include "framebuffer.h"
+#include "console.h"
+
+static unsigned char startLine;
+static unsigned int fgColor, bgColor;
+
+// What is on the input line, so it can be redrawn after history is added
+static char input[CONSOLE_COLS];
+
+static int lineY(int line) {
+    return (startLine + 8 * line) % SSD1351HEIGHT;
+}
+
+static void setStartLine(unsigned char line) {
+#if defined(SSD1351_FRAMEBUFFER)
+    // the panel must hold the new rows before they scroll into view
+    displayFlush();
+#endif
+    writeCommand(SSD1351_CMD_STARTLINE);
+    writeData(line);
+}
+
+// Draw a line of text, then clear whatever is right of it
+static void drawLineText(int line, const char *s, int n, unsigned int color) {
+    int y = lineY(line);
+    int x = 0;
+
+    while (n-- > 0) {
+        drawChar(x, y, *s++, color, bgColor, 1);
+        x += 6;
+    }
+    fillRect(x, y, SSD1351WIDTH - x, 8, bgColor);
+}
+
+// Only called right after scrollLine(), which leaves the input line blank
+static void redrawInput(void) {
+    int y = consoleInputY();
+    int col;
+
+    for (col = 0; col < CONSOLE_COLS; col++)
+        if (input[col] && input[col] != ' ')
+            drawChar(col * 6, y, input[col], fgColor, bgColor, 1);
+}
+
+// Scroll up one text line and blank the new input line
+static void scrollLine(void) {
+    // clear the top line while it is still at the top, where a blank
+    // line is less noticeable than at the bottom
+    fillRect(0, lineY(0), SSD1351WIDTH, 8, bgColor);
+    startLine = (startLine + 8) % SSD1351HEIGHT;
+    setStartLine(startLine);
+}
+
+void consoleInit(unsigned int fg, unsigned int bg) {
+    int col;
+
+    fgColor = fg;
+    bgColor = bg;
+    startLine = 0;
+    for (col = 0; col < CONSOLE_COLS; col++)
+        input[col] = 0;
+
+    setStartLine(0);
+    fillScreen(bg);
+}
+
+int consoleInputY(void) {
+    return lineY(CONSOLE_ROWS - 1);
+}
+
+void consoleInputPut(int x, char c) {
+    int col = x / 6;
+
+    if (col < 0 || col >= CONSOLE_COLS)
+        return;
+    input[col] = c;
+    drawChar(col * 6, consoleInputY(), c, fgColor, bgColor, 1);
+}
+
+void consoleNewline(void) {
+    int col;
+
+    scrollLine();
+    for (col = 0; col < CONSOLE_COLS; col++)
+        input[col] = 0;
+}
+
+void consolePrint(const char *s, unsigned int color) {
+    int n;
+
+    do {
+        for (n = 0; n < CONSOLE_COLS && s[n]; n++)
+            ;
+        // the history line takes the place of the old input line, which
+        // is redrawn on the fresh line below
+        scrollLine();
+        drawLineText(CONSOLE_ROWS - 2, s, n, color);
+        redrawInput();
+        s += n;
+    } while (*s);
+}
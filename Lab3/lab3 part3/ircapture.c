@@ -0,0 +1,124 @@
+//*****************************************************************************
+//
+// ircapture.c
+//
+// Timer A runs in edge-time capture mode on both edges, counting down with
+// the prescaler as an 8-bit extension: a 24-bit count that reloads every
+// 2^24 ticks.  A pulse is the difference between the counts latched at its
+// two edges.  The reload interrupt only counts reloads, so a pulse that
+// spans one is still measured and one that spans two is reported as
+// IR_GAP.
+//
+// The level of each pulse is not read back from the pin, which belongs to
+// the timer; it alternates from edge to edge, starting again from a space
+// after every IR_GAP since the line idles high.
+//
+// The ring is only written by the interrupt (head) and only read by the
+// main loop (tail), so neither side needs to mask interrupts.
+//
+//*****************************************************************************
+
+// Driverlib includes
+#include "hw_types.h"
+#include "hw_memmap.h"
+#include "interrupt.h"
+#include "timer.h"
+#include "rom.h"
+#include "rom_map.h"
+
+#include "ircapture.h"
+
+#define COUNT_MASK  IR_GAP      // the 24-bit count
+
+IRCaptureStats irCaptureStats;
+
+static volatile unsigned long ring[IR_RING_SIZE];
+static volatile unsigned int head, tail;
+
+static unsigned long timer;
+static unsigned long lastCount;
+static unsigned int reloads = 2;    // no edge seen yet: the first pulse is a gap
+static unsigned char inMark;        // level of the pulse now running
+static unsigned char lost;          // an overrun dropped pulses
+
+static void push(unsigned long pulse) {
+    unsigned int depth = head - tail;
+
+    if (depth == IR_RING_SIZE) {
+        irCaptureStats.overruns++;
+        lost = 1;
+        return;
+    }
+    if (lost) {
+        // the decoder must not splice this pulse onto the ones before it
+        pulse |= IR_GAP;
+        lost = 0;
+    }
+    ring[head & (IR_RING_SIZE - 1)] = pulse;
+    head++;
+    if (depth + 1 > irCaptureStats.maxDepth)
+        irCaptureStats.maxDepth = depth + 1;
+}
+
+// An edge latched count; the pulse that just ended goes into the ring
+static void edge(unsigned long count) {
+    unsigned long width;
+
+    // the counter runs down, so with one reload in between the pulse fits
+    // in a period only if the count is now above where it was
+    if (reloads == 0 || (reloads == 1 && count > lastCount))
+        width = (lastCount - count) & COUNT_MASK;
+    else
+        width = IR_GAP;
+    if (width == IR_GAP)
+        inMark = 0;
+
+    push(width | (inMark ? IR_MARK : 0));
+    irCaptureStats.edges++;
+    inMark = !inMark;
+    lastCount = count;
+    reloads = 0;
+}
+
+static void irCaptureHandler(void) {
+    unsigned long status = MAP_TimerIntStatus(timer, true);
+    unsigned long count;
+
+    MAP_TimerIntClear(timer, status);
+
+    if (status & TIMER_CAPA_EVENT) {
+        count = MAP_TimerValueGet(timer, TIMER_A) & COUNT_MASK;
+
+        // Both pending: the reload came first if the count latched by the
+        // edge has only just started down from the top
+        if ((status & TIMER_TIMA_TIMEOUT) && count > COUNT_MASK / 2) {
+            if (reloads < 2)
+                reloads++;
+            status &= ~TIMER_TIMA_TIMEOUT;
+        }
+        edge(count);
+    }
+
+    if ((status & TIMER_TIMA_TIMEOUT) && reloads < 2)
+        reloads++;
+}
+
+void irCaptureInit(unsigned long timerBase) {
+    timer = timerBase;
+
+    MAP_TimerConfigure(timer, TIMER_CFG_SPLIT_PAIR | TIMER_CFG_A_CAP_TIME);
+    MAP_TimerControlEvent(timer, TIMER_A, TIMER_EVENT_BOTH_EDGES);
+    MAP_TimerPrescaleSet(timer, TIMER_A, 0xFF);
+    MAP_TimerLoadSet(timer, TIMER_A, 0xFFFF);
+    MAP_TimerIntRegister(timer, TIMER_A, irCaptureHandler);
+    MAP_TimerIntEnable(timer, TIMER_CAPA_EVENT | TIMER_TIMA_TIMEOUT);
+    MAP_TimerEnable(timer, TIMER_A);
+}
+
+int irRead(unsigned long *pulse) {
+    if (tail == head)
+        return 0;
+    *pulse = ring[tail & (IR_RING_SIZE - 1)];
+    tail++;
+    return 1;
+}
@@ -0,0 +1,315 @@
+//*****************************************************************************
+//
+// irdecode.c
+//
+// Two engines run the protocol table.  The pulse engine covers leader
+// codes whose bits are a fixed mark and a variable space (pulse distance,
+// NEC) or a variable mark and a fixed space (pulse width, SIRC).  The
+// Manchester engine covers RC-5, which has no leader: it walks the frame
+// in half bits, takes each bit from the level of its second half and
+// drops the frame at any bit without a transition in the middle.
+//
+// Every width is accepted within TOLERANCE percent of nominal, which
+// covers a receiver module stretching marks and shortening spaces by a
+// couple of hundred microseconds without letting the protocols' windows
+// overlap.
+//
+//*****************************************************************************
+
+#include "ircapture.h"
+#include "irdecode.h"
+
+#define TOLERANCE   30      // percent either side of a nominal width
+
+enum { PULSE_DISTANCE, PULSE_WIDTH, MANCHESTER };
+
+enum {
+    S_IDLE,                 // waiting for a leader mark, or RC-5's first mark
+    S_LEADER,               // leader mark seen, its space comes next
+    S_MARK,                 // inside a frame, a bit mark comes next
+    S_SPACE,                // inside a frame, a bit space comes next
+    S_REPEAT                // repeat space seen, waiting for the stop mark
+};
+
+enum { NONE, FRAME, REPEAT };
+
+typedef struct {
+    const char *name;
+    unsigned char coding;
+    unsigned char minBits, maxBits;
+    unsigned short leaderMark, leaderSpace;     // us; 0 for no leader
+    unsigned short repeatSpace;                 // us; 0 if held keys resend the frame
+    unsigned short zeroMark, zeroSpace;         // us; Manchester: half a bit
+    unsigned short oneMark, oneSpace;
+    int (*unpack)(unsigned long data, int bits, IRCode *code);
+} IRDescriptor;
+
+typedef struct {
+    unsigned char state;
+    unsigned char bits;         // bits so far; Manchester: half bits
+    unsigned char firstHalf;    // Manchester: level of this bit's first half
+    unsigned long data;
+} Machine;
+
+static int unpackNec(unsigned long data, int bits, IRCode *code);
+static int unpackRc5(unsigned long data, int bits, IRCode *code);
+static int unpackSirc(unsigned long data, int bits, IRCode *code);
+
+static const IRDescriptor protocols[IR_PROTOCOLS] = {
+    //  name    coding          bits    leader      repeat zero      one
+    {   "NEC",  PULSE_DISTANCE, 32, 32, 9000, 4500, 2250,  560, 560, 560, 1690, unpackNec },
+    {   "RC5",  MANCHESTER,     14, 14, 0,    0,    0,     889, 889, 889, 889,  unpackRc5 },
+    {   "SIRC", PULSE_WIDTH,    12, 20, 2400, 600,  0,     600, 600, 1200, 600, unpackSirc },
+};
+
+IRDecodeStats irDecodeStats;
+
+static Machine machines[IR_PROTOCOLS];
+static IRCode last;                 // the held key
+static unsigned long lastData;
+static unsigned char held;
+
+//*****************************************************************************
+// Protocol checks: validate a complete frame and split it into fields
+//*****************************************************************************
+
+// Address, inverted address, command, inverted command.  An address that
+// is not followed by its inverse is a 16-bit extended NEC one.
+static int unpackNec(unsigned long data, int bits, IRCode *code) {
+    unsigned int address = data & 0xFF;
+    unsigned int command = (data >> 16) & 0xFF;
+
+    (void)bits;
+    if ((command ^ (data >> 24)) != 0xFF)
+        return 0;
+    if ((address ^ ((data >> 8) & 0xFF)) != 0xFF)
+        address = data & 0xFFFF;
+    code->address = address;
+    code->command = command;
+    return 1;
+}
+
+// Start bit, field bit, toggle, 5 address and 6 command bits.  A clear
+// field bit is the seventh command bit of RC-5X.  The toggle bit flips at
+// every new key press, so it tells a held key from the same key pressed
+// again.
+static int unpackRc5(unsigned long data, int bits, IRCode *code) {
+    (void)bits;
+    if (!(data & 0x2000))
+        return 0;
+    code->address = (data >> 6) & 0x1F;
+    code->command = (data & 0x3F) | (data & 0x1000 ? 0 : 0x40);
+    return 1;
+}
+
+// 7 command bits, then 5, 8 or 13 address bits
+static int unpackSirc(unsigned long data, int bits, IRCode *code) {
+    if (bits != 12 && bits != 15 && bits != 20)
+        return 0;
+    code->address = data >> 7;
+    code->command = data & 0x7F;
+    return 1;
+}
+
+//*****************************************************************************
+// Engines
+//*****************************************************************************
+
+static int fits(unsigned long w, unsigned int us) {
+    unsigned long nominal = IR_US(us);
+
+    return us && w >= nominal * (100 - TOLERANCE) / 100 &&
+           w <= nominal * (100 + TOLERANCE) / 100;
+}
+
+static int complete(int p, IRCode *code) {
+    Machine *m = &machines[p];
+
+    m->state = S_IDLE;
+    if (!protocols[p].unpack(m->data, m->bits, code)) {
+        irDecodeStats.rejected[p]++;
+        return NONE;
+    }
+    return FRAME;
+}
+
+static int pulseCoded(int p, unsigned long w, int mark, IRCode *code) {
+    const IRDescriptor *d = &protocols[p];
+    Machine *m = &machines[p];
+    int bit;
+
+    switch (m->state) {
+    case S_IDLE:
+        break;
+
+    case S_LEADER:
+        if (!mark && fits(w, d->leaderSpace)) {
+            m->bits = 0;
+            m->data = 0;
+            m->state = S_MARK;
+            return NONE;
+        }
+        if (!mark && fits(w, d->repeatSpace)) {
+            m->state = S_REPEAT;
+            return NONE;
+        }
+        break;
+
+    case S_MARK:
+        if (!mark)
+            break;
+        if (d->coding == PULSE_DISTANCE) {
+            if (!fits(w, d->zeroMark))
+                break;
+            m->state = S_SPACE;
+            return NONE;
+        }
+        if (fits(w, d->zeroMark))
+            bit = 0;
+        else if (fits(w, d->oneMark))
+            bit = 1;
+        else
+            break;
+        m->data |= (unsigned long)bit << m->bits;
+        if (++m->bits == d->maxBits)
+            return complete(p, code);
+        m->state = S_SPACE;
+        return NONE;
+
+    case S_SPACE:
+        if (mark)
+            break;
+        if (d->coding == PULSE_WIDTH) {
+            if (fits(w, d->zeroSpace)) {
+                m->state = S_MARK;
+                return NONE;
+            }
+            // longer than a bit space: the frame ended at the last mark
+            if (m->bits >= d->minBits)
+                return complete(p, code);
+            break;
+        }
+        if (fits(w, d->zeroSpace))
+            bit = 0;
+        else if (fits(w, d->oneSpace))
+            bit = 1;
+        else
+            break;
+        m->data |= (unsigned long)bit << m->bits;
+        if (++m->bits == d->maxBits)
+            return complete(p, code);
+        m->state = S_MARK;
+        return NONE;
+
+    case S_REPEAT:
+        m->state = S_IDLE;
+        return mark && fits(w, d->zeroMark) ? REPEAT : NONE;
+    }
+
+    // not part of a frame; it may be the next leader
+    m->state = mark && fits(w, d->leaderMark) ? S_LEADER : S_IDLE;
+    return NONE;
+}
+
+static int manchester(int p, unsigned long w, int mark, IRCode *code) {
+    const IRDescriptor *d = &protocols[p];
+    Machine *m = &machines[p];
+    int halves = fits(w, d->zeroMark) ? 1 : fits(w, 2 * d->zeroMark) ? 2 : 0;
+
+    if (m->state == S_IDLE) {
+        // the start bit is a 1, so its first half is still idle line and
+        // a frame opens with the mark of its second half
+        if (!mark || !halves)
+            return NONE;
+        m->state = S_MARK;
+        m->bits = 1;
+        m->firstHalf = 0;
+        m->data = 0;
+    } else if (!halves) {
+        // the second half of a final 0 runs on into the idle line
+        if (mark || m->bits != 2 * d->maxBits - 1) {
+            m->state = S_IDLE;
+            return NONE;
+        }
+        halves = 1;
+    }
+
+    while (halves--) {
+        if (!(m->bits & 1)) {
+            m->firstHalf = mark;
+        } else if (mark == m->firstHalf) {
+            m->state = S_IDLE;
+            return NONE;
+        } else {
+            m->data = m->data << 1 | mark;
+        }
+        if (++m->bits == 2 * d->maxBits) {
+            m->bits = d->maxBits;
+            return complete(p, code);
+        }
+    }
+    return NONE;
+}
+
+//*****************************************************************************
+// Interface
+//*****************************************************************************
+
+void irDecodeInit(void) {
+    int p;
+
+    for (p = 0; p < IR_PROTOCOLS; p++)
+        machines[p].state = S_IDLE;
+    held = 0;
+}
+
+int irDecode(unsigned long pulse, IRCode *code) {
+    unsigned long w = IR_WIDTH(pulse);
+    int mark = IR_IS_MARK(pulse);
+    int p, q, result = NONE;
+
+    for (p = 0; p < IR_PROTOCOLS; p++) {
+        if (protocols[p].coding == MANCHESTER)
+            result = manchester(p, w, mark, code);
+        else
+            result = pulseCoded(p, w, mark, code);
+        if (result != NONE)
+            break;
+    }
+
+    if (result == REPEAT && !(held && last.protocol == p))
+        result = NONE;
+
+    if (result != NONE) {
+        // first to validate wins: the other machines start over
+        for (q = 0; q < IR_PROTOCOLS; q++)
+            if (q != p)
+                machines[q].state = S_IDLE;
+
+        if (result == REPEAT) {
+            *code = last;
+            code->repeat = 1;
+        } else {
+            // without repeat frames a held key resends the same frame
+            code->protocol = p;
+            code->repeat = held && last.protocol == p && lastData == machines[p].data &&
+                           !protocols[p].repeatSpace;
+            last = *code;
+            last.repeat = 0;
+            lastData = machines[p].data;
+            held = 1;
+        }
+        irDecodeStats.decoded[p]++;
+    }
+
+    // the line went quiet, or pulses were lost: the key is up.  A frame
+    // that only the quiet could end has been reported above.
+    if (w == IR_GAP)
+        irDecodeInit();
+
+    return result != NONE;
+}
+
+const char *irProtocolName(unsigned int protocol) {
+    return protocol < IR_PROTOCOLS ? protocols[protocol].name : "?";
+}
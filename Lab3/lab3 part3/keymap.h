@@ -0,0 +1,66 @@
+//*****************************************************************************
+//
+// keymap.h
+//
+// Binds decoded IR codes to the logical keys of the text entry keypad.
+// The table starts out with the lab's NEC remote and learns other remotes
+// at run time, one key after another.  Codes are hashed into a small
+// open-addressing table, so a lookup costs the same however many remotes
+// are bound.
+//
+// RAM: 5 bytes per slot, 320 bytes as configured.
+//
+//*****************************************************************************
+
+#ifndef _KEYMAP_H
+#define _KEYMAP_H
+
+#include "irdecode.h"
+
+// Uncomment to keep the table in the SimpleLink serial flash file system
+// across resets.  The network processor must be running (sl_Start())
+// before keymapInit().
+// #define KEYMAP_FLASH
+
+#define KEYMAP_BITS     6
+#define KEYMAP_SLOTS    (1 << KEYMAP_BITS)
+#define KEYMAP_LIMIT    (KEYMAP_SLOTS * 3 / 4)  // bindings kept at most
+
+enum {
+    KEY_NONE,               // the code is not bound
+    KEY_0, KEY_1, KEY_2, KEY_3, KEY_4, KEY_5, KEY_6, KEY_7, KEY_8, KEY_9,
+    KEY_DELETE,
+    KEY_ENTER,
+    KEY_COUNT
+};
+
+typedef struct {
+    unsigned long searches;     // lookups and bindings
+    unsigned long probes;       // slots compared, over all searches
+    unsigned long bindings;     // codes bound now
+} KeymapStats;
+
+extern KeymapStats keymapStats;
+
+// Bind the lab remote, then replace it with the saved table if there is one
+void keymapInit(void);
+
+// The key code is bound to, or KEY_NONE
+int keymapLookup(const IRCode *code);
+
+// Learn mode: the next codes are bound to KEY_0 .. KEY_ENTER in turn.  If
+// the table has no room for another remote it starts over from the lab one.
+void keymapLearnStart(void);
+
+int keymapLearning(void);
+
+// Bind code to the key being learned; returns the key to learn next, or
+// KEY_NONE once the last one is bound and the table saved.  A code already
+// taken by an earlier key in this round is refused and the same key asked
+// for again.
+int keymapLearn(const IRCode *code);
+
+// "0" .. "9", "DELETE", "ENTER"
+const char *keyName(int key);
+
+#endif // _KEYMAP_H
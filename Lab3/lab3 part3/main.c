@@ -29,7 +29,6 @@
 #include "rom.h"
 #include "rom_map.h"
 #include "pin.h"
-#include "math.h"
 #include "string.h"
 #include "uart.h"
 
@@ -38,23 +37,19 @@
 #include "timer_if.h"
 #include "pin_mux_config.h"
 #include "Adafruit_GFX.h"
+#include "console.h"
+#include "Adafruit_SSD1351.h"
+#include "displaylist.h"
+#include "ircapture.h"
+#include "irdecode.h"
+#include "keymap.h"
 
 
 #define APPLICATION_VERSION     "1.1.1"
 #define APP_NAME        "Board to Board Texting"
 
-#define BUTTON_ZERO     255
-#define BUTTON_ONE      32895
-#define BUTTON_TWO      16575
-#define BUTTON_THREE    49215
-#define BUTTON_FOUR     8415
-#define BUTTON_FIVE     41055
-#define BUTTON_SIX      24735
-#define BUTTON_SEVEN    57375
-#define BUTTON_EIGHT    4335
-#define BUTTON_NINE     36975
-#define BUTTON_LAST     765
-#define BUTTON_MUTE     2295
+// repeats of a held key that start learn mode, about two seconds
+#define LEARN_HOLD      16
 // Color definitions
 #define BLACK           0x0000
 #define BLUE            0x001F
@@ -85,12 +80,6 @@ typedef struct {
 //*****************************************************************************
 //                 GLOBAL VARIABLES -- Start
 //*****************************************************************************
-static int buffer[100];
-static int number[100];
-static int value = 1;
-static int i = 0;
-static int detected = 0;
-static int delta = 0;
 static char lastkey = '\0';
 static int start = 0;
 
@@ -108,11 +97,11 @@ static char keySet[10][4][2] = {{"","","",""},// space for 0
 static int keyBuffer[10] = {0,0,0,0,0,0,0,0,0,0};
 
 static PinSetting OC = {.port = GPIOA3_BASE, .pin = 0x80};
-static PinSetting Receiver = {.port = GPIOA1_BASE, .pin = 0x8};
 static Coordinate top = {.x = 0, .y = 0};
-static Coordinate bot = {.x = 0, .y = 120};
 static Msg message;
 static Msg rmsg;
+static char inbox[160];
+static volatile int received = 0;
 
 
 #if defined(ccs) || defined(gcc)
@@ -146,8 +135,8 @@ DisplayBanner(char * AppName)
     Report("\n\n\n\r");
 }
 
-void deleteChar(int x, int y) {
-    fillRect(x, y, 6, 8, BLACK);
+void deleteChar(int x) {
+    consoleInputPut(x, ' ');
 }
 
 //*****************************************************************************
@@ -184,40 +173,6 @@ BoardInit(void)
 }
 
 
-int sameArray(int a[], int b[]) {
-    int index;
-    for (index = 0; index < 16; index++) {
-        if (a[index] != b[index]) {
-            return 0;
-        }
-    }
-    return 1;
-}
-
-void findPattern()
-{
-    int pattern[16] = {0,0,0,0,
-                       0,0,1,0,
-                       1,1,1,1,
-                       1,1,0,1};
-    int index, find = 0;
-    for (index = 0; index < i-16; index++) {
-        if (sameArray(buffer+index, pattern)) {
-            find = 1;
-            break;
-        }
-    }
-    if (find) {
-        int j, k;
-        for (k = 0, j = index + 16; j < i; j++, k++) {
-            number[k] = buffer[j];
-        }
-        detected = 1;
-        i = k;
-    }
-}
-
-
 static void ResetButton()
 {
     Timer_IF_InterruptClear(TIMERA0_BASE);
@@ -242,21 +197,19 @@ void Process(char key, int keyIndex, int numKeys)
      if (keyBuffer[keyIndex] == numKeys) {
          keyBuffer[keyIndex] = 0;
          top.x -= 6;
-         deleteChar(top.x, top.y);
-         setCursor(top.x, top.y);
+         deleteChar(top.x);
      }
      if (numKeys == 3) {
          switch (keyBuffer[keyIndex]) {
          case 0:
-             Outstr(keySet[keyIndex][keyBuffer[keyIndex]]);
+             consoleInputPut(top.x, keySet[keyIndex][keyBuffer[keyIndex]][0]);
              message.message[message.index] = keySet[keyIndex][keyBuffer[keyIndex]][0];
              break;
          case 1:
          case 2:
              top.x -= 6;
-             deleteChar(top.x, top.y);
-             setCursor(top.x, top.y);
-             Outstr(keySet[keyIndex][keyBuffer[keyIndex]]);
+             deleteChar(top.x);
+             consoleInputPut(top.x, keySet[keyIndex][keyBuffer[keyIndex]][0]);
              message.message[message.index] = keySet[keyIndex][keyBuffer[keyIndex]][0];
              break;
          default:
@@ -266,16 +219,15 @@ void Process(char key, int keyIndex, int numKeys)
      else {
          switch (keyBuffer[keyIndex]) {
          case 0:
-             Outstr(keySet[keyIndex][keyBuffer[keyIndex]]);
+             consoleInputPut(top.x, keySet[keyIndex][keyBuffer[keyIndex]][0]);
              message.message[message.index] = keySet[keyIndex][keyBuffer[keyIndex]][0];
              break;
          case 1:
          case 2:
          case 3:
              top.x -= 6;
-             deleteChar(top.x, top.y);
-             setCursor(top.x, top.y);
-             Outstr(keySet[keyIndex][keyBuffer[keyIndex]]);
+             deleteChar(top.x);
+             consoleInputPut(top.x, keySet[keyIndex][keyBuffer[keyIndex]][0]);
              message.message[message.index] = keySet[keyIndex][keyBuffer[keyIndex]][0];
              break;
          default:
@@ -288,63 +240,50 @@ void Process(char key, int keyIndex, int numKeys)
 
 static void UARTIntHandler()
 {
-    TimerIntClear(TIMERA1_BASE, TIMER_A);
-    TimerDisable(TIMERA1_BASE, TIMER_A);
+    TimerIntClear(TIMERA2_BASE, TIMER_A);
+    TimerDisable(TIMERA2_BASE, TIMER_A);
     UARTIntClear(UARTA1_BASE, UART_INT_RX);
     Report("Interrupt\n\r");
     char tmp = UARTCharGet(UARTA1_BASE);
     rmsg.message[rmsg.index++] = tmp;
-    TimerEnable(TIMERA1_BASE, TIMER_A);
+    TimerEnable(TIMERA2_BASE, TIMER_A);
 }
 
-static void GPIOEdgeHandler(void) {
-    unsigned long ulStatus;
-    TimerDisable(TIMERA0_BASE, TIMER_A);
-    TimerDisable(TIMERA2_BASE, TIMER_A);
-    Timer_IF_InterruptClear(TIMERA2_BASE);
-    ulStatus = MAP_GPIOIntStatus (Receiver.port, true);
-    MAP_GPIOIntClear(Receiver.port, ulStatus);
+// Decode captured pulses until a key code comes out; returns 0 once the
+// ring is empty
+static int ReadCode(IRCode *code) {
+    unsigned long pulse;
 
-    if(delta > 3)
-        value = 1;
-    else
-        value = 0;
-
-    delta = 0;
-
-    if (i >= 16 && !detected) {
-        findPattern();
+    while (irRead(&pulse)) {
+        if (irDecode(pulse, code))
+            return 1;
     }
-    if (!detected)
-        buffer[i] = value;
-    else
-        number[i] = value;
+    return 0;
+}
 
+// Bind a code in learn mode and ask for the next key
+static void Learn(const IRCode *code) {
+    int key = keymapLearn(code);
 
-    i++;
-    TimerEnable(TIMERA2_BASE, TIMER_A);
-    TimerEnable(TIMERA0_BASE, TIMER_A);
-
+    if (key != KEY_NONE)
+        Report("Press %s\n\r", keyName(key));
+    else
+        Report("Keys learned\n\r");
 }
+
 static void PrintBottom()
 {
-    TimerIntClear(TIMERA1_BASE, TIMER_A);
-    TimerDisable(TIMERA1_BASE, TIMER_A);
+    TimerIntClear(TIMERA2_BASE, TIMER_A);
+    TimerDisable(TIMERA2_BASE, TIMER_A);
     Report("End\n\r");
     rmsg.message[rmsg.index] = '\0';
-    setCursor(bot.x, bot.y);
-    fillRect(bot.x, bot.y, 128, 8, BLACK);
-    Outstr(rmsg.message);
+    // hand the message to the main loop, which owns the display
+    strcpy(inbox, rmsg.message);
+    received = 1;
     rmsg.message[0] = '\0';
     rmsg.index = 0;
 }
 
-static void TimerCountHandler(void)
-{
-    Timer_IF_InterruptClear(TIMERA2_BASE);
-    delta++;
-}
-
 //*****************************************************************************
 //
 //! Main  Function
@@ -352,8 +291,8 @@ static void TimerCountHandler(void)
 //*****************************************************************************
 int main()
 {
-    int k = 0;
-    int sum = 0;
+    IRCode code;
+    int key, held = 0;
     message.index = 0;
     BoardInit();
     PinMuxConfig();
@@ -361,26 +300,22 @@ int main()
     // Configuring the timers
     //
     Timer_IF_Init(PRCM_TIMERA0, TIMERA0_BASE, TIMER_CFG_PERIODIC, TIMER_A, 0);
-    Timer_IF_Init(PRCM_TIMERA1, TIMERA1_BASE, TIMER_CFG_PERIODIC, TIMER_A, 0);
     Timer_IF_Init(PRCM_TIMERA2, TIMERA2_BASE, TIMER_CFG_PERIODIC, TIMER_A, 0);
     //
     // Setup the interrupts for the timer timeouts.
     //
     Timer_IF_IntSetup(TIMERA0_BASE, TIMER_A, ResetButton);
-    Timer_IF_IntSetup(TIMERA1_BASE, TIMER_A, PrintBottom);
-    Timer_IF_IntSetup(TIMERA2_BASE, TIMER_A, TimerCountHandler);
+    Timer_IF_IntSetup(TIMERA2_BASE, TIMER_A, PrintBottom);
 
     TimerLoadSet(TIMERA0_BASE, TIMER_A, MILLISECONDS_TO_TICKS(1000));
-    TimerLoadSet(TIMERA1_BASE, TIMER_A, MILLISECONDS_TO_TICKS(1000));
-    TimerLoadSet(TIMERA2_BASE, TIMER_A, MILLISECONDS_TO_TICKS(0.5));
-
-
-    GPIOIntRegister(Receiver.port, GPIOEdgeHandler);
-    GPIOIntTypeSet(Receiver.port, Receiver.pin, GPIO_FALLING_EDGE);
-    int ulStatus = MAP_GPIOIntStatus(Receiver.port, false);
-    GPIOIntClear(Receiver.port, ulStatus);
+    TimerLoadSet(TIMERA2_BASE, TIMER_A, MILLISECONDS_TO_TICKS(1000));
 
-    GPIOIntEnable(Receiver.port, Receiver.pin);
+    //
+    // IR receiver on PIN_02, captured by TIMERA1
+    //
+    MAP_PinConfigSet(PIN_02, PIN_TYPE_STD_PU, PIN_STRENGTH_6MA);
+    irCaptureInit(TIMERA1_BASE);
+    keymapInit();
 
     ClearTerm();
     InitTerm();
@@ -412,7 +347,7 @@ int main()
     MAP_SPICSEnable(GSPI_BASE); // Enables chip select
     MAP_GPIOPinWrite(OC.port, OC.pin, OC.pin);
     Adafruit_Init();
-    fillScreen(BLACK);
+    consoleInit(WHITE, BLACK);
 
     //Enable and set up the UARTA1
     MAP_UARTConfigSetExpClk(UARTA1_BASE,MAP_PRCMPeripheralClockGet(PRCM_UARTA1),
@@ -426,64 +361,88 @@ int main()
 
 
     while (1) {
-        if(!(detected && i >= 16)){
+        if (received) {
+            received = 0;
+            consolePrint(inbox, GREEN);
+        }
+        if (!ReadCode(&code)) {
+#ifdef SSD1351_DISPLAYLIST
+            // nothing decoded yet: move some queued drawing to the panel
+            displayDrain(LIST_DRAIN_OPS);
+#endif
+            continue;
+        }
+
+        key = keymapLookup(&code);
+        if (keymapLearning()) {
+            if (!code.repeat)
+                Learn(&code);
             continue;
         }
 
-        sum = 0;
-        for(k = 0; k < 16; k++){
-            sum += (int)number[k]*pow(2, (15-k));
+        // holding 1, or a key no remote is bound to, starts learn mode
+        if (!code.repeat)
+            held = 0;
+        else if ((key == KEY_1 || key == KEY_NONE) && ++held == LEARN_HOLD) {
+            keymapLearnStart();
+            Report("Learning: press %s\n\r", keyName(KEY_0));
+        }
+
+        // holding a key only repeats delete
+        if (code.repeat && key != KEY_DELETE)
+            continue;
+        if (key == KEY_NONE) {
+            Report("%s remote %u, key %u not bound\n\r",
+                   irProtocolName(code.protocol), code.address, code.command);
+            continue;
         }
 
         TimerLoadSet(TIMERA0_BASE, TIMER_A, MILLISECONDS_TO_TICKS(1000));
         TimerEnable(TIMERA0_BASE, TIMER_A);
-        TimerDisable(TIMERA2_BASE, TIMER_A);
 
-        setCursor(top.x, top.y);
-
-        switch(sum){
-            case(BUTTON_ZERO):
-                Outstr(" ");
+        switch(key){
+            case(KEY_0):
+                consoleInputPut(top.x, ' ');
                 message.message[++message.index] = ' ';
                 lastkey = '0';
                 break;
-            case(BUTTON_ONE):
+            case(KEY_1):
                 Report("1");
                 lastkey = '1';
                 break;
-            case(BUTTON_TWO):
+            case(KEY_2):
                 Process('2', 2, 3);
                 break;
-            case(BUTTON_THREE):
+            case(KEY_3):
                 Process('3', 3, 3);
                 break;
-            case(BUTTON_FOUR):
+            case(KEY_4):
                 Process('4', 4, 3);
                 break;
-            case(BUTTON_FIVE):
+            case(KEY_5):
                 Process('5', 5, 3);
                 break;
-            case(BUTTON_SIX):
+            case(KEY_6):
                 Process('6', 6, 3);
                 break;
-            case(BUTTON_SEVEN):
+            case(KEY_7):
                 Process('7', 7, 4);
                 break;
-            case(BUTTON_EIGHT):
+            case(KEY_8):
                 Process('8', 8, 3);
                 break;
-            case(BUTTON_NINE):
+            case(KEY_9):
                 Process('9', 9, 4);
                 break;
-            case(BUTTON_LAST):
+            case(KEY_DELETE):
                 Report("Delete\n\r");
                 top.x -= 6;
-                deleteChar(top.x, top.y);
+                deleteChar(top.x);
                 top.x -= 6;
                 lastkey = 'd';
                 message.message[message.index--] = '\0';
                 break;
-            case(BUTTON_MUTE):
+            case(KEY_ENTER):
                 Report("Enter\n\r");
                 lastkey = 'e';
                 // print message for now
@@ -491,30 +450,27 @@ int main()
                 Report("message: %s\n\r", message.message);
                 int index;
                 for (index = 0; index < message.index; index++) {
-                    top.x -= 6;
-                    deleteChar(top.x, top.y);
                     UARTCharPut(UARTA1_BASE, message.message[index]);
                 }
                 message.index = 0;
                 message.message[message.index] = '\0';
-                TimerEnable(TIMERA2_BASE, TIMER_A);
                 TimerDisable(TIMERA0_BASE, TIMER_A);
                 start = 0;
-                top.x -= 6;
+                // keep the sent text on screen as history
+                consoleNewline();
+                top.x = -6;     // column 0 after the += 6 below
                 break;
             default:
-                Report("Unknown code %d\n\r", sum);
+                Report("Unknown key %d\n\r", key);
                 top.x -= 6;
                 lastkey = 'u';
                 break;
         }
         Report("Pressed\n\r");
-        i = 0;
-        detected = 0;
         top.x += 6;
         if (top.x > 122) {
             top.x = 0;
-            top.y += 8;
+            consoleNewline();
         }
     }
 
@@ -80,6 +80,7 @@ void PinMuxConfig(void)
     PRCMPeripheralClkEnable(PRCM_GSPI, PRCM_RUN_MODE_CLK);
     PRCMPeripheralClkEnable(PRCM_UARTA0, PRCM_RUN_MODE_CLK);
     PRCMPeripheralClkEnable(PRCM_UARTA1, PRCM_RUN_MODE_CLK);
+    PRCMPeripheralClkEnable(PRCM_TIMERA1, PRCM_RUN_MODE_CLK);
 
     //
     // Configure PIN_58 for GPIO Output
@@ -88,10 +89,9 @@ void PinMuxConfig(void)
     GPIODirModeSet(GPIOA0_BASE, 0x8, GPIO_DIR_MODE_OUT);
 
     //
-    // Configure PIN_02 for GPIO Input
+    // Configure PIN_02 for TimerCP2 GT_CCP02
     //
-    PinTypeGPIO(PIN_02, PIN_MODE_0, false);
-    GPIODirModeSet(GPIOA1_BASE, 0x8, GPIO_DIR_MODE_IN);
+    PinTypeTimer(PIN_02, PIN_MODE_12);
 
     //
     // Configure PIN_18 for GPIO Output
@@ -0,0 +1,32 @@
+//*****************************************************************************
+//
+// rgb565.h
+//
+// Bulk operations on RGB565 pixel buffers.  Buffers need only be 2-byte
+// aligned; the fill, the 50% blend and the converter align themselves and
+// then work on two pixels per 32-bit word.
+//
+//*****************************************************************************
+
+#ifndef _RGB565_H
+#define _RGB565_H
+
+// Set n pixels to color
+void fill16(unsigned short *dst, unsigned int color, unsigned long n);
+
+// Copy n pixels; the buffers must not overlap
+void copy16(unsigned short *dst, const unsigned short *src, unsigned long n);
+
+// dst = (dst + src) / 2 per channel, rounded down
+void blend50(unsigned short *dst, const unsigned short *src, unsigned long n);
+
+// dst = dst + (src - dst) * alpha / 255 per channel, with alpha rounded to
+// 1/32 steps; alpha 0 leaves dst alone and 255 copies src
+void blendAlpha(unsigned short *dst, const unsigned short *src,
+                unsigned int alpha, unsigned long n);
+
+// Convert n packed 8-bit R, G, B triples, as in a 24-bit image, to RGB565
+// exactly as Color565() does
+void color565Buffer(unsigned short *dst, const unsigned char *rgb, unsigned long n);
+
+#endif // _RGB565_H
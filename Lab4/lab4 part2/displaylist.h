@@ -0,0 +1,64 @@
+//*****************************************************************************
+//
+// displaylist.h
+//
+// Deferred drawing for programs that cannot block on the SPI bus, such as
+// the IR receivers.  Enabled by defining SSD1351_DISPLAYLIST in
+// Adafruit_SSD1351.h.
+//
+// Every fill, opaque or transparent glyph, remap change and raw command or
+// data byte is recorded as a compact op in a ring and the drawing call
+// returns at once.  displayDrain() sends a few ops to the panel; call it
+// from the idle loop or from a low-priority timer interrupt.  Fills larger
+// than LIST_SLICE_PIXELS go out in slices of whole rows, one per op sent,
+// so no single step holds the bus for long.  The screen is only current
+// after displayFence().
+//
+// Drawing calls must all come from one context.  If the ring fills up, the
+// drawing call sends the oldest op itself and counts a stall.
+//
+// RAM: 10 bytes per op, 1.3 KB as configured.
+//
+//*****************************************************************************
+
+#ifndef _DISPLAYLIST_H
+#define _DISPLAYLIST_H
+
+#include "Adafruit_SSD1351.h"
+
+#define LIST_MAX_OPS        128     // ring size, a power of two
+#define LIST_DRAIN_OPS      4       // ops a main loop sends per idle pass
+#define LIST_SLICE_PIXELS   512     // most pixels one step of a drain sends
+
+typedef struct {
+    unsigned long recorded;     // ops queued by drawing calls
+    unsigned long drained;      // ops sent to the panel
+    unsigned long stalls;       // drawing calls that found the ring full
+    unsigned long maxDepth;     // most ops waiting at once
+} DisplayListStats;
+
+#ifdef SSD1351_DISPLAYLIST
+
+extern DisplayListStats displayListStats;
+
+// Send up to maxOps queued ops (or slices of a large fill); returns how
+// many ops are still waiting.  Safe to call from an interrupt that preempts
+// the drawing code: a drain that is already running is left to finish.
+int displayDrain(int maxOps);
+
+// Send everything queued so far
+void displayFence(void);
+
+// Called by the primitives with bounds already clipped to the screen, by
+// drawChar() for glyphs that are entirely inside the clip rectangle, and by
+// the command layer; each returns 0 while the list itself is being drained
+// and the caller should go to the panel directly
+int listFillRect(int x, int y, int w, int h, unsigned int color);
+int listGlyph(int x, int y, unsigned char c, unsigned int color,
+              unsigned int bg, unsigned char size);
+int listWrite(unsigned char byte, int isData);
+int listRemap(unsigned char rotation);
+
+#endif // SSD1351_DISPLAYLIST
+
+#endif // _DISPLAYLIST_H
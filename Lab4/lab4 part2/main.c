@@ -19,6 +19,7 @@
 
 // Common interface includes
 #include "Adafruit_GFX.h"
+#include "console.h"
 #include "uart_if.h"
 #include "timer_if.h"
 #include "pin_mux_config.h"
@@ -104,9 +105,10 @@ static int keyBuffer[10] = {0,0,0,0,0,0,0,0,0,0};
 
 static PinSetting OC = {.port = GPIOA3_BASE, .pin = 0x80};
 static Coordinate top = {.x = 0, .y = 0};
-static Coordinate bot = {.x = 0, .y = 120};
 static Msg message;
 static Msg rmsg;
+static char inbox[160];
+static volatile int received = 0;
 
 
 //*****************************************************************************
@@ -293,21 +295,19 @@ void Process(char key, int keyIndex, int numKeys)
      if (keyBuffer[keyIndex] == numKeys) {
          keyBuffer[keyIndex] = 0;
          top.x -= 6;
-         deleteChar(top.x, top.y);
-         setCursor(top.x, top.y);
+         deleteChar(top.x);
      }
      if (numKeys == 3) {
          switch (keyBuffer[keyIndex]) {
          case 0:
-             Outstr(keySet[keyIndex][keyBuffer[keyIndex]]);
+             consoleInputPut(top.x, keySet[keyIndex][keyBuffer[keyIndex]][0]);
              message.message[message.index] = keySet[keyIndex][keyBuffer[keyIndex]][0];
              break;
          case 1:
          case 2:
              top.x -= 6;
-             deleteChar(top.x, top.y);
-             setCursor(top.x, top.y);
-             Outstr(keySet[keyIndex][keyBuffer[keyIndex]]);
+             deleteChar(top.x);
+             consoleInputPut(top.x, keySet[keyIndex][keyBuffer[keyIndex]][0]);
              message.message[message.index] = keySet[keyIndex][keyBuffer[keyIndex]][0];
              break;
          default:
@@ -317,16 +317,15 @@ void Process(char key, int keyIndex, int numKeys)
      else {
          switch (keyBuffer[keyIndex]) {
          case 0:
-             Outstr(keySet[keyIndex][keyBuffer[keyIndex]]);
+             consoleInputPut(top.x, keySet[keyIndex][keyBuffer[keyIndex]][0]);
              message.message[message.index] = keySet[keyIndex][keyBuffer[keyIndex]][0];
              break;
          case 1:
          case 2:
          case 3:
              top.x -= 6;
-             deleteChar(top.x, top.y);
-             setCursor(top.x, top.y);
-             Outstr(keySet[keyIndex][keyBuffer[keyIndex]]);
+             deleteChar(top.x);
+             consoleInputPut(top.x, keySet[keyIndex][keyBuffer[keyIndex]][0]);
              message.message[message.index] = keySet[keyIndex][keyBuffer[keyIndex]][0];
              break;
          default:
@@ -355,9 +354,9 @@ static void PrintBottom()
     Report("End\n\r");
     rmsg.message[rmsg.index] = '\0';
     Report("%s\n\r", rmsg.message);
-    setCursor(bot.x, bot.y);
-    fillRect(bot.x, bot.y, 128, 8, BLACK);
-    Outstr(rmsg.message);
+    // hand the message to the main loop, which owns the display
+    strcpy(inbox, rmsg.message);
+    received = 1;
     rmsg.message[0] = '\0';
     rmsg.index = 0;
 }
@@ -403,8 +402,8 @@ DisplayBanner(char * AppName)
     Report("\n\n\n\r");
 }
 
-void deleteChar(int x, int y) {
-    fillRect(x, y, 6, 8, BLACK);
+void deleteChar(int x) {
+    consoleInputPut(x, ' ');
 }
 
 
@@ -426,7 +425,7 @@ int main() {
     InitTerm();
     DisplayBanner("Lab 4");
     Adafruit_Init();
-    fillScreen(BLACK);
+    consoleInit(WHITE, BLACK);
 
     // variable setups
     unsigned long ulStatus;
@@ -441,6 +440,10 @@ int main() {
     MAP_TimerEnable(TIMERA0_BASE, TIMER_A);
 
     while(1) {
+        if (received) {
+            received = 0;
+            consolePrint(inbox, GREEN);
+        }
         if (isSampling == 1) {
             isSampling = 0;
             sample_buffer[sample_num-1] = ((signed long) readADC()) - 372;
@@ -463,18 +466,17 @@ int main() {
             int num = decode();
 
             if (num > 0) {
-                setCursor(top.x, top.y);
                 TimerLoadSet(TIMERA1_BASE, TIMER_A, MILLISECONDS_TO_TICKS(1000));
                 TimerEnable(TIMERA1_BASE, TIMER_TIMA_TIMEOUT);
                 switch (num) {
                 case BUTTON_ZERO:
-                    Outstr(keySet[0][0]);
+                    consoleInputPut(top.x, keySet[0][0][0]);
                     message.message[++message.index] = ' ';
                     lastkey = '0';
                     Report("%d\n\r", num);
                     break;
                 case BUTTON_ONE:
-                    Outstr(keySet[1][0]);
+                    consoleInputPut(top.x, keySet[1][0][0]);
                     lastkey = '1';
                     Report("%d\n\r", num);
                     break;
@@ -513,7 +515,7 @@ int main() {
                 case BUTTON_STAR:
                     lastkey = '*';
                     top.x -= 6;
-                    deleteChar(top.x, top.y);
+                    deleteChar(top.x);
                     top.x -= 6;
                     message.message[message.index--] = '\0';
                     Report("%d\n\r", num);
@@ -526,8 +528,6 @@ int main() {
                     Report("message: %s\n\r", message.message);
                     int index;
                     for (index = 0; index < message.index; index++) {
-                        top.x -= 6;
-                        deleteChar(top.x, top.y);
                         UARTCharPut(UARTA1_BASE, message.message[index]);
                     }
                     message.index = 0;
@@ -535,7 +535,9 @@ int main() {
 
                     TimerDisable(TIMERA1_BASE, TIMER_A);
                     start = 0;
-                    top.x -= 6;
+                    // keep the sent text on screen as history
+                    consoleNewline();
+                    top.x = -6;     // column 0 after the += 6 below
                     break;
                     break;
                 default:
@@ -546,7 +548,7 @@ int main() {
                  top.x += 6;
                  if (top.x > 122) {
                      top.x = 0;
-                     top.y += 8;
+                     consoleNewline();
                  }
             }
 
@@ -0,0 +1,142 @@
+//*****************************************************************************
+//
+// rgb565.c
+//
+// SWAR kernels: a 32-bit word holds two pixels and plain integer operations
+// work on both at once.  The per-channel arithmetic keeps carries from
+// crossing into the neighbouring field with masks:
+//
+//   average   (a & b) + (((a ^ b) & 0xF7DEF7DE) >> 1) halves every channel
+//             of both pixels; the mask clears each channel's low bit so the
+//             shift cannot move it into the channel below.
+//   alpha     a pixel spread out as 00000GGGGGG00000RRRRR000000BBBBB leaves
+//             at least five clear bits above each field, enough for the
+//             product with a 5-bit alpha, so one multiply blends all three
+//             channels.
+//
+// The Cortex-M4 SIMD instructions (UADD16, UHADD16, SEL) work on 8- and
+// 16-bit lanes, which the 5/6/5 fields do not line up with, so they would
+// need the same masking and gain nothing here.
+//
+//*****************************************************************************
+
+#include <string.h>
+
+#include "rgb565.h"
+
+// Two pixels.  GCC is told the word may alias the unsigned short buffers it
+// is read from; other compilers do not reorder across such accesses.
+#if defined(__GNUC__)
+typedef unsigned int __attribute__((__may_alias__)) PixelPair;
+#else
+typedef unsigned int PixelPair;
+#endif
+
+#define LOW_BITS    0xF7DEF7DEu     // every channel but its lowest bit
+#define SPREAD      0x07E0F81Fu     // green high, red and blue low
+
+#define ODD(p)      ((unsigned long)(p) & 2)
+
+void fill16(unsigned short *dst, unsigned int color, unsigned long n) {
+    PixelPair pair, *w;
+
+    color &= 0xFFFF;
+    if (n && ODD(dst)) {
+        *dst++ = color;
+        n--;
+    }
+
+    pair = color | color << 16;
+    w = (PixelPair *)dst;
+    for (; n >= 8; n -= 8, w += 4) {
+        w[0] = pair;
+        w[1] = pair;
+        w[2] = pair;
+        w[3] = pair;
+    }
+    for (; n >= 2; n -= 2)
+        *w++ = pair;
+    if (n)
+        *(unsigned short *)w = color;
+}
+
+// The run-time library's memcpy() already moves whole words, or several at
+// a time, and handles the misaligned cases; a word loop here only lost to it
+void copy16(unsigned short *dst, const unsigned short *src, unsigned long n) {
+    memcpy(dst, src, n * sizeof(*dst));
+}
+
+static unsigned int average(unsigned int a, unsigned int b) {
+    return (a & b) + (((a ^ b) & LOW_BITS) >> 1);
+}
+
+void blend50(unsigned short *dst, const unsigned short *src, unsigned long n) {
+    const PixelPair *s;
+    PixelPair *d;
+
+    if (ODD(dst) != ODD(src)) {
+        while (n--) {
+            *dst = average(*dst, *src++);
+            dst++;
+        }
+        return;
+    }
+    if (n && ODD(dst)) {
+        *dst = average(*dst, *src++);
+        dst++;
+        n--;
+    }
+
+    d = (PixelPair *)dst;
+    s = (const PixelPair *)src;
+    for (; n >= 2; n -= 2, d++)
+        *d = average(*d, *s++);
+    if (n)
+        *(unsigned short *)d = average(*(unsigned short *)d, *(const unsigned short *)s);
+}
+
+// One pixel: spread both, blend every channel with one multiply, pack
+static unsigned short mix(unsigned int bg, unsigned int fg, unsigned int a) {
+    bg = (bg | bg << 16) & SPREAD;
+    fg = (fg | fg << 16) & SPREAD;
+    bg = (bg + (((fg - bg) * a) >> 5)) & SPREAD;
+    return bg | bg >> 16;
+}
+
+void blendAlpha(unsigned short *dst, const unsigned short *src,
+                unsigned int alpha, unsigned long n) {
+    unsigned int a = (alpha + 4) >> 3;
+
+    if (a == 0)
+        return;
+    if (a >= 32) {
+        copy16(dst, src, n);
+        return;
+    }
+    while (n--) {
+        *dst = mix(*dst, *src++, a);
+        dst++;
+    }
+}
+
+static unsigned int pack565(const unsigned char *p) {
+    return (p[0] & 0xF8) << 8 | (p[1] & 0xFC) << 3 | p[2] >> 3;
+}
+
+void color565Buffer(unsigned short *dst, const unsigned char *rgb, unsigned long n) {
+    PixelPair *w;
+
+    if (n && ODD(dst)) {
+        *dst++ = pack565(rgb);
+        rgb += 3;
+        n--;
+    }
+
+    // two pixels per store; the first one goes in the low half, which is
+    // the lower address on the little-endian core
+    w = (PixelPair *)dst;
+    for (; n >= 2; n -= 2, rgb += 6)
+        *w++ = pack565(rgb) | pack565(rgb + 3) << 16;
+    if (n)
+        *(unsigned short *)w = pack565(rgb);
+}
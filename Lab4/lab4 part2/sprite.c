@@ -0,0 +1,184 @@
+//*****************************************************************************
+//
+// sprite.c
+//
+// For each sprite that moved, the box it was drawn in and the box it now
+// covers are redrawn together as their bounding box when the two overlap,
+// which for a small step is barely larger than the sprite.  Boxes far
+// apart are redrawn separately instead, since their bounding box would
+// take in everything between them.
+//
+// Each row of a box is composed into a line buffer, background first and
+// then the sprites in the order they were added, and streamed into one
+// window.  A buffered or display list build cannot take a burst, so there
+// the rows go through drawRGBBitmap() like the image blitters.  Rows are
+// always composed in RGB565; in an indexed build the background colour is
+// a palette index, looked up as each row is composed.
+//
+//*****************************************************************************
+
+#include "Adafruit_GFX.h"
+#include "Adafruit_SSD1351.h"
+#include "framebuffer.h"
+#include "rgb565.h"
+#include "sprite.h"
+
+#if defined(SSD1351_FRAMEBUFFER) || defined(SSD1351_STRIPBUFFER) || defined(SSD1351_DISPLAYLIST)
+#define ROWS_AS_BITMAPS
+#endif
+
+#define LINE_MAX    (SSD1351WIDTH > SSD1351HEIGHT ? SSD1351WIDTH : SSD1351HEIGHT)
+
+typedef struct {
+    int x0, y0, x1, y1;     // inclusive; empty when x0 > x1 or y0 > y1
+} Box;
+
+static Sprite *sprites[SPRITE_MAX];
+static int numSprites;
+static unsigned int bgColor;
+static const unsigned short *bgImage;
+static unsigned short line[LINE_MAX];
+
+void spriteBackground(unsigned int color, const unsigned short *image) {
+    bgColor = color;
+    bgImage = image;
+}
+
+int spriteAdd(Sprite *s) {
+    if (numSprites == SPRITE_MAX)
+        return 0;
+    s->drawn = 0;
+    sprites[numSprites++] = s;
+    return 1;
+}
+
+static int boxEmpty(const Box *b) {
+    return b->x0 > b->x1 || b->y0 > b->y1;
+}
+
+static long boxArea(const Box *b) {
+    return boxEmpty(b) ? 0 : (long)(b->x1 - b->x0 + 1) * (b->y1 - b->y0 + 1);
+}
+
+// The part of a sprite-sized box at x, y that is inside the clip rectangle
+static Box spriteBox(const Sprite *s, int x, int y) {
+    Box b;
+
+    b.x0 = x < clipRect.x0 ? clipRect.x0 : x;
+    b.y0 = y < clipRect.y0 ? clipRect.y0 : y;
+    b.x1 = x + s->w - 1 > clipRect.x1 ? clipRect.x1 : x + s->w - 1;
+    b.y1 = y + s->h - 1 > clipRect.y1 ? clipRect.y1 : y + s->h - 1;
+    return b;
+}
+
+// Fill line with row y of the box as it should look
+static void composeRow(const Box *b, int y) {
+    int n = b->x1 - b->x0 + 1;
+    int i, x, x0, x1;
+
+    if (bgImage)
+        copy16(line, bgImage + (long)y * width() + b->x0, n);
+    else
+#ifdef SSD1351_INDEXED
+        fill16(line, displayPaletteColor(bgColor), n);
+#else
+        fill16(line, bgColor, n);
+#endif
+
+    for (i = 0; i < numSprites; i++) {
+        const Sprite *s = sprites[i];
+        const unsigned short *src;
+
+        if (!s->visible || y < s->y || y >= s->y + s->h)
+            continue;
+        x0 = s->x > b->x0 ? s->x : b->x0;
+        x1 = s->x + s->w - 1 < b->x1 ? s->x + s->w - 1 : b->x1;
+        src = s->image + (long)(y - s->y) * s->w;
+        for (x = x0; x <= x1; x++)
+            if (src[x - s->x] != s->key)
+                line[x - b->x0] = src[x - s->x];
+    }
+}
+
+static void redraw(const Box *b) {
+    int n = b->x1 - b->x0 + 1;
+    int y;
+
+    if (boxEmpty(b))
+        return;
+
+#ifdef ROWS_AS_BITMAPS
+    for (y = b->y0; y <= b->y1; y++) {
+        composeRow(b, y);
+        drawRGBBitmap(b->x0, y, line, n, 1);
+    }
+#else
+    startWrite();
+    setAddrWindow(b->x0, b->y0, n, b->y1 - b->y0 + 1);
+    for (y = b->y0; y <= b->y1; y++) {
+        composeRow(b, y);
+        writePixels(line, n);
+    }
+    endWrite();
+#endif
+}
+
+void spriteRemove(Sprite *s) {
+    Box old;
+    int i;
+
+    for (i = 0; i < numSprites && sprites[i] != s; i++)
+        ;
+    if (i == numSprites)
+        return;
+    for (; i < numSprites - 1; i++)
+        sprites[i] = sprites[i + 1];
+    numSprites--;
+
+    if (s->drawn) {
+        old = spriteBox(s, s->drawnX, s->drawnY);
+        redraw(&old);
+        s->drawn = 0;
+    }
+}
+
+void spriteFrame(void) {
+    Box old, cur, both;
+    int i;
+
+    for (i = 0; i < numSprites; i++) {
+        Sprite *s = sprites[i];
+
+        if (s->drawn == s->visible &&
+                (!s->visible || (s->drawnX == s->x && s->drawnY == s->y)))
+            continue;
+
+        old = spriteBox(s, s->drawnX, s->drawnY);
+        if (!s->drawn)
+            old.x1 = old.x0 - 1;
+        cur = spriteBox(s, s->x, s->y);
+        if (!s->visible)
+            cur.x1 = cur.x0 - 1;
+
+        if (boxEmpty(&old)) {
+            redraw(&cur);
+        } else if (boxEmpty(&cur)) {
+            redraw(&old);
+        } else {
+            both.x0 = old.x0 < cur.x0 ? old.x0 : cur.x0;
+            both.y0 = old.y0 < cur.y0 ? old.y0 : cur.y0;
+            both.x1 = old.x1 > cur.x1 ? old.x1 : cur.x1;
+            both.y1 = old.y1 > cur.y1 ? old.y1 : cur.y1;
+            if (boxArea(&both) <= boxArea(&old) + boxArea(&cur)) {
+                redraw(&both);
+            } else {
+                redraw(&old);
+                redraw(&cur);
+            }
+        }
+
+        s->drawn = s->visible;
+        s->drawnX = s->x;
+        s->drawnY = s->y;
+    }
+}
@@ -31,9 +31,15 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <stdlib.h>
+
 #include "Adafruit_GFX.h"
 #include "Adafruit_SSD1351.h"
 #include "glcdfont.h"
+#include "glyphcache.h"
+#include "displaylist.h"
+#include "framebuffer.h"
+#include "stripbuffer.h"
 //#define pgm_read_byte(addr) (*(const unsigned char *)(addr))
 
 int cursor_x=0;
@@ -43,6 +49,12 @@ unsigned int textcolor = 0xFFFF;
 unsigned int textbgcolor = 0xFFFF;
 char wrap = 1;
 
+static unsigned char rotation = 0;
+static int _width = WIDTH;
+static int _height = HEIGHT;
+
+ClipRect clipRect = { 0, 0, WIDTH - 1, HEIGHT - 1 };
+
 
 /*
 Adafruit_GFX(int w, int h):
@@ -58,21 +70,64 @@ Adafruit_GFX(int w, int h):
 }
 */
 
-// Draw a circle outline
+// O(1) rejection: nonzero if the box x0..x1, y0..y1 misses the clip
+// rectangle entirely, so the shape need not be rasterized at all
+static int clipMisses(int x0, int y0, int x1, int y1) {
+  return x1 < clipRect.x0 || x0 > clipRect.x1 ||
+         y1 < clipRect.y0 || y0 > clipRect.y1;
+}
+
+// Emit the points x = xs..xe of the circle octants at distance y, for the
+// quadrants selected in corners (same bits as drawCircleHelper).  Each
+// octant contributes one run.  xs == 0 only comes from drawCircle(), where
+// the runs meet on the axes and the left and right halves are drawn as one.
+static void circleRuns(int x0, int y0, int xs, int xe, int y,
+               unsigned char corners, unsigned int color) {
+  int n = xe - xs + 1;
+
+  if (n <= 0) return;
+
+  if (xs == 0) {
+    drawFastHLine(x0 - xe, y0 + y, 2*xe + 1, color);
+    drawFastHLine(x0 - xe, y0 - y, 2*xe + 1, color);
+    drawFastVLine(x0 + y, y0 - xe, 2*xe + 1, color);
+    drawFastVLine(x0 - y, y0 - xe, 2*xe + 1, color);
+    return;
+  }
+  if (corners & 0x4) {
+    drawFastHLine(x0 + xs, y0 + y, n, color);
+    drawFastVLine(x0 + y, y0 + xs, n, color);
+  }
+  if (corners & 0x2) {
+    drawFastHLine(x0 + xs, y0 - y, n, color);
+    drawFastVLine(x0 + y, y0 - xe, n, color);
+  }
+  if (corners & 0x8) {
+    drawFastVLine(x0 - y, y0 + xs, n, color);
+    drawFastHLine(x0 - xe, y0 + y, n, color);
+  }
+  if (corners & 0x1) {
+    drawFastVLine(x0 - y, y0 - xe, n, color);
+    drawFastHLine(x0 - xe, y0 - y, n, color);
+  }
+}
+
+// Draw a circle outline.  The midpoint walk is unchanged, but points are
+// collected into runs of constant y and each run is drawn as one burst.
 void drawCircle(int x0, int y0, int r, unsigned int color) {
   int f = 1 - r;
   int ddF_x = 1;
   int ddF_y = -2 * r;
   int x = 0;
   int y = r;
+  int xs = 0;   // first x of the run at the current y
 
-  drawPixel(x0  , y0+r, color);
-  drawPixel(x0  , y0-r, color);
-  drawPixel(x0+r, y0  , color);
-  drawPixel(x0-r, y0  , color);
+  if (clipMisses(x0 - r, y0 - r, x0 + r, y0 + r)) return;
 
   while (x<y) {
     if (f >= 0) {
+      circleRuns(x0, y0, xs, x, y, 0xF, color);
+      xs = x + 1;
       y--;
       ddF_y += 2;
       f += ddF_y;
@@ -80,16 +135,8 @@ void drawCircle(int x0, int y0, int r, unsigned int color) {
     x++;
     ddF_x += 2;
     f += ddF_x;
-  
-    drawPixel(x0 + x, y0 + y, color);
-    drawPixel(x0 - x, y0 + y, color);
-    drawPixel(x0 + x, y0 - y, color);
-    drawPixel(x0 - x, y0 - y, color);
-    drawPixel(x0 + y, y0 + x, color);
-    drawPixel(x0 - y, y0 + x, color);
-    drawPixel(x0 + y, y0 - x, color);
-    drawPixel(x0 - y, y0 - x, color);
   }
+  circleRuns(x0, y0, xs, x, y, 0xF, color);
 }
 
 void drawCircleHelper( int x0, int y0,
@@ -99,9 +146,14 @@ void drawCircleHelper( int x0, int y0,
   int ddF_y = -2 * r;
   int x     = 0;
   int y     = r;
+  int xs    = 1;
+
+  if (clipMisses(x0 - r, y0 - r, x0 + r, y0 + r)) return;
 
   while (x<y) {
     if (f >= 0) {
+      circleRuns(x0, y0, xs, x, y, cornername, color);
+      xs = x + 1;
       y--;
       ddF_y += 2;
       f     += ddF_y;
@@ -109,29 +161,150 @@ void drawCircleHelper( int x0, int y0,
     x++;
     ddF_x += 2;
     f     += ddF_x;
-    if (cornername & 0x4) {
-      drawPixel(x0 + x, y0 + y, color);
-      drawPixel(x0 + y, y0 + x, color);
-    } 
-    if (cornername & 0x2) {
-      drawPixel(x0 + x, y0 - y, color);
-      drawPixel(x0 + y, y0 - x, color);
-    }
-    if (cornername & 0x8) {
-      drawPixel(x0 - y, y0 + x, color);
-      drawPixel(x0 - x, y0 + y, color);
-    }
-    if (cornername & 0x1) {
-      drawPixel(x0 - y, y0 - x, color);
-      drawPixel(x0 - x, y0 - y, color);
+  }
+  circleRuns(x0, y0, xs, x, y, cornername, color);
+}
+
+//*****************************************************************************
+// Scanline span rasterizer for the filled shapes.  Every covered row gets
+// exactly one span, so no pixel is sent twice, and spans are handed over in
+// row order so identical neighbours merge into a single rect.  The window
+// shadow in Adafruit_OLED.c then turns a change of span into one SETCOLUMN.
+//*****************************************************************************
+
+typedef struct {
+  int x0, x1;             // extent of the pending rows
+  int y, rows;
+  unsigned int color;
+} SpanRun;
+
+static void spanFlush(SpanRun *s) {
+  if (s->rows)
+    fillRect(s->x0, s->y, s->x1 - s->x0 + 1, s->rows, s->color);
+  s->rows = 0;
+}
+
+// Rows must be added top to bottom
+static void spanAdd(SpanRun *s, int y, int x0, int x1) {
+  if (s->rows && y == s->y + s->rows && x0 == s->x0 && x1 == s->x1) {
+    s->rows++;
+    return;
+  }
+  spanFlush(s);
+  s->x0 = x0;
+  s->x1 = x1;
+  s->y = y;
+  s->rows = 1;
+}
+
+// Half-width of each row of a radius r disc, dy = 0..r, taken from the same
+// midpoint walk fillCircleHelper() uses so the covered pixels are identical.
+// Column x of the walk reaches down to row y, and column y down to row x; a
+// row is as wide as the widest column that reaches it.
+static void circleWidths(int r, short *hw) {
+  int f     = 1 - r;
+  int ddF_x = 1;
+  int ddF_y = -2 * r;
+  int x     = 0;
+  int y     = r;
+  int dy;
+
+  for (dy = 0; dy <= r; dy++)
+    hw[dy] = 0;
+
+  while (x<y) {
+    if (f >= 0) {
+      y--;
+      ddF_y += 2;
+      f     += ddF_y;
     }
+    x++;
+    ddF_x += 2;
+    f     += ddF_x;
+
+    if (hw[y] < x) hw[y] = x;
+    if (x <= r && hw[x] < y) hw[x] = y;
   }
+  for (dy = r; dy > 0; dy--)
+    if (hw[dy-1] < hw[dy]) hw[dy-1] = hw[dy];
+}
+
+// Rows from the top of the screen down: the top corners, the straight
+// middle (delta rows) and the bottom corners, all centred on x0..x1.
+static void roundSpans(int x0, int x1, int y0, int r, int delta,
+               unsigned int color) {
+  short hw[SSD1351HEIGHT];
+  SpanRun s;
+  int dy;
+
+  if (clipMisses(x0 - r, y0 - r, x1 + r, y0 + delta + r)) return;
+
+  s.rows = 0;
+  s.color = color;
+  circleWidths(r, hw);
+
+  for (dy = r; dy > 0; dy--)
+    spanAdd(&s, y0 - dy, x0 - hw[dy], x1 + hw[dy]);
+  for (dy = 0; dy <= delta; dy++)
+    spanAdd(&s, y0 + dy, x0 - hw[0], x1 + hw[0]);
+  for (dy = 1; dy <= r; dy++)
+    spanAdd(&s, y0 + delta + dy, x0 - hw[dy], x1 + hw[dy]);
+  spanFlush(&s);
 }
 
 void fillCircle(int x0, int y0, int r,
 			      unsigned int color) {
-  drawFastVLine(x0, y0-r, 2*r+1, color);
-  fillCircleHelper(x0, y0, r, 3, 0, color);
+  // the width table only covers radii the screen can show whole
+  if (r < 0 || r >= SSD1351HEIGHT) {
+    drawFastVLine(x0, y0-r, 2*r+1, color);
+    fillCircleHelper(x0, y0, r, 3, 0, color);
+    return;
+  }
+  roundSpans(x0, x0, y0, r, 0, color);
+}
+
+static unsigned long isqrt(unsigned long long n) {
+  unsigned long long bit = 1ULL << 62, root = 0;
+
+  while (bit > n)
+    bit >>= 2;
+  while (bit) {
+    if (n >= root + bit) {
+      n -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return root;
+}
+
+// Filled axis-aligned ellipse.  Each visible row's half-width comes from the
+// ellipse equation with the radii taken half a pixel out, in integers:
+// floor(X/2 * sqrt(1 - D^2/R^2)) with X = 2rx+1, R = 2ry+1, D = 2dy.
+void fillEllipse(int x0, int y0, int rx, int ry, unsigned int color) {
+  unsigned long long X2, R2;
+  SpanRun s;
+  int y, top, bottom, dy, hw;
+
+  if (rx < 0 || ry < 0) return;
+
+  if (clipMisses(x0 - rx, y0 - ry, x0 + rx, y0 + ry)) return;
+
+  X2 = (unsigned long long)(2*rx + 1) * (2*rx + 1);
+  R2 = (unsigned long long)(2*ry + 1) * (2*ry + 1);
+  top = y0 - ry < clipRect.y0 ? clipRect.y0 : y0 - ry;
+  bottom = y0 + ry > clipRect.y1 ? clipRect.y1 : y0 + ry;
+
+  s.rows = 0;
+  s.color = color;
+  for (y = top; y <= bottom; y++) {
+    dy = y < y0 ? y0 - y : y - y0;
+    hw = isqrt(X2 * (R2 - 4ULL*dy*dy) / R2) / 2;
+    spanAdd(&s, y, x0 - hw, x0 + hw);
+  }
+  spanFlush(&s);
 }
 
 // Used to do circles and roundrects
@@ -144,6 +317,8 @@ void fillCircleHelper(int x0, int y0, int r,
   int x     = 0;
   int y     = r;
 
+  if (clipMisses(x0 - r, y0 - r, x0 + r, y0 + r + delta)) return;
+
   while (x<y) {
     if (f >= 0) {
       y--;
@@ -165,23 +340,96 @@ void fillCircleHelper(int x0, int y0, int r,
   }
 }
 
+//*****************************************************************************
+// Cohen-Sutherland line clipping.  The segment is cut back to the clip
+// rectangle grown by a pixel on each side, since a Bresenham pixel can sit
+// up to half a pixel off the ideal line and the integer intersections are
+// only exact to within one.  drawLine() uses the result to pick where along
+// its major axis to start and stop, not which pixels to set, so a clipped
+// line lights exactly the pixels the unclipped one would.
+//*****************************************************************************
+
+#define CLIP_LEFT   1
+#define CLIP_RIGHT  2
+#define CLIP_TOP    4
+#define CLIP_BOTTOM 8
+
+static int outcode(int x, int y, int grow) {
+  int code = 0;
+
+  if (x < clipRect.x0 - grow) code |= CLIP_LEFT;
+  else if (x > clipRect.x1 + grow) code |= CLIP_RIGHT;
+  if (y < clipRect.y0 - grow) code |= CLIP_TOP;
+  else if (y > clipRect.y1 + grow) code |= CLIP_BOTTOM;
+  return code;
+}
+
+// Returns 0 if the segment misses the grown clip rectangle
+static int clipSegment(int *x0, int *y0, int *x1, int *y1) {
+  int c0 = outcode(*x0, *y0, 1);
+  int c1 = outcode(*x1, *y1, 1);
+  long long x, y;
+  int c;
+
+  while (c0 | c1) {
+    if (c0 & c1) return 0;
+    c = c0 ? c0 : c1;
+    if (c & CLIP_TOP) {
+      y = clipRect.y0 - 1;
+      x = *x0 + (long long)(*x1 - *x0) * (y - *y0) / (*y1 - *y0);
+    } else if (c & CLIP_BOTTOM) {
+      y = clipRect.y1 + 1;
+      x = *x0 + (long long)(*x1 - *x0) * (y - *y0) / (*y1 - *y0);
+    } else if (c & CLIP_LEFT) {
+      x = clipRect.x0 - 1;
+      y = *y0 + (long long)(*y1 - *y0) * (x - *x0) / (*x1 - *x0);
+    } else {
+      x = clipRect.x1 + 1;
+      y = *y0 + (long long)(*y1 - *y0) * (x - *x0) / (*x1 - *x0);
+    }
+    if (c == c0) {
+      *x0 = x; *y0 = y;
+      c0 = outcode(*x0, *y0, 1);
+    } else {
+      *x1 = x; *y1 = y;
+      c1 = outcode(*x1, *y1, 1);
+    }
+  }
+  return 1;
+}
+
 // Bresenham's algorithm - thx wikpedia
+// Pixels that share a major-axis line are drawn as a single run.
+// Off-screen ends are not walked: the error term at the first visible
+// step is computed directly.
 void drawLine(int x0, int y0, int x1, int y1, unsigned int color) {
   int steep;
   int dx, dy;
 	int err;
 	int ystep;
+	int start, end;
+  int cx0 = x0, cy0 = y0, cx1 = x1, cy1 = y1;
+  long long k, n;
+
+  // both ends beyond the same edge: nothing of the line is visible
+  if (outcode(x0, y0, 0) & outcode(x1, y1, 0)) return;
+  if (!clipSegment(&cx0, &cy0, &cx1, &cy1)) return;
 
 	steep = abs(y1 - y0) > abs(x1 - x0);
   if (steep) {
     swap(x0, y0);
     swap(x1, y1);
+    swap(cx0, cy0);
+    swap(cx1, cy1);
   }
 
   if (x0 > x1) {
     swap(x0, x1);
     swap(y0, y1);
   }
+  if (cx0 > cx1) {
+    swap(cx0, cx1);
+  }
 
   dx = x1 - x0;
   dy = abs(y1 - y0);
@@ -194,13 +442,28 @@ void drawLine(int x0, int y0, int x1, int y1, unsigned int color) {
     ystep = -1;
   }
 
-  for (; x0<=x1; x0++) {
-    if (steep) {
-      drawPixel(y0, x0, color);
-    } else {
-      drawPixel(x0, y0, color);
-    }
+  // visible stretch of the major axis, a pixel wider for the rounding
+  start = cx0 - 1 > x0 ? cx0 - 1 : x0;
+  end = cx1 + 1 < x1 ? cx1 + 1 : x1;
+
+  // jump k steps ahead: the minor axis has moved n times, where n is what
+  // brings the error term back into 0..dx-1
+  k = start - x0;
+  n = k * dy - err > 0 ? (k * dy - err + dx - 1) / dx : 0;
+  y0 += ystep * n;
+  err = err - k * dy + n * dx;
+
+  for (x0 = start; x0<=end; x0++) {
     err -= dy;
+    if (err < 0 || x0 == end) {
+      // last pixel at this minor coordinate: the run ends here
+      if (steep) {
+        drawFastVLine(y0, start, x0 - start + 1, color);
+      } else {
+        drawFastHLine(start, y0, x0 - start + 1, color);
+      }
+      start = x0 + 1;
+    }
     if (err < 0) {
       y0 += ystep;
       err += dx;
@@ -212,6 +475,7 @@ void drawLine(int x0, int y0, int x1, int y1, unsigned int color) {
 void drawRect(int x, int y,
 			    int w, int h,
 			    unsigned int color) {
+  if (clipMisses(x, y, x + w - 1, y + h - 1)) return;
   drawFastHLine(x, y, w, color);
   drawFastHLine(x, y+h-1, w, color);
   drawFastVLine(x, y, h, color);
@@ -248,6 +512,7 @@ void fillScreen(unsigned int color) {
 // Draw a rounded rectangle
 void drawRoundRect(int x, int y, int w,
   int h, int r, unsigned int color) {
+  if (clipMisses(x, y, x + w - 1, y + h - 1)) return;
   // smarter version
   drawFastHLine(x+r  , y    , w-2*r, color); // Top
   drawFastHLine(x+r  , y+h-1, w-2*r, color); // Bottom
@@ -263,12 +528,23 @@ void drawRoundRect(int x, int y, int w,
 // Fill a rounded rectangle
 void fillRoundRect(int x, int y, int w,
 				 int h, int r, unsigned int color) {
-  // smarter version
-  fillRect(x+r, y, w-2*r, h, color);
+  if (w <= 0 || h <= 0) return;
 
-  // draw four corners
-  fillCircleHelper(x+w-r-1, y+r, r, 1, h-2*r-1, color);
-  fillCircleHelper(x+r    , y+r, r, 2, h-2*r-1, color);
+  // keep the corner centres from crossing on short or narrow rects
+  if (r > (w-1)/2) r = (w-1)/2;
+  if (r > (h-1)/2) r = (h-1)/2;
+  if (r < 0) r = 0;
+
+  // the width table only covers radii the screen can show whole
+  if (r >= SSD1351HEIGHT) {
+    fillRect(x+r, y, w-2*r, h, color);
+    fillCircleHelper(x+w-r-1, y+r, r, 1, h-2*r-1, color);
+    fillCircleHelper(x+r    , y+r, r, 2, h-2*r-1, color);
+    return;
+  }
+
+  // corner centres at (x+r, y+r) and (x+w-r-1, y+h-r-1)
+  roundSpans(x+r, x+w-r-1, y+r, r, h-2*r-1, color);
 }
 
 // Draw a triangle
@@ -280,22 +556,31 @@ void drawTriangle(int x0, int y0,
   drawLine(x2, y2, x0, y0, color);
 }
 
+//*****************************************************************************
+// Edge walkers for the triangle and polygon fillers.  x is kept in 16.16
+// fixed point with half a pixel of bias, so x >> 16 is the crossing rounded
+// to the nearest column; the only division is the slope, once per edge.
+//*****************************************************************************
+
+typedef struct {
+  long x;                 // 16.16 crossing at the current row
+  long dx;                // 16.16 step per row
+} EdgeWalk;
+
+// Start an edge at (xa, ya) heading for (xb, yb), yb >= ya
+static void edgeStart(EdgeWalk *e, int xa, int ya, int xb, int yb) {
+  e->x = (long)xa * 65536 + 0x8000;
+  e->dx = yb > ya ? (long)((long long)(xb - xa) * 65536 / (yb - ya)) : 0;
+}
+
 // Fill a triangle
 void fillTriangle ( int x0, int y0,
 				  int x1, int y1,
 				  int x2, int y2, unsigned int color) {
 
-  int a, b, y, last;
-  int
-    dx01 = x1 - x0,
-    dy01 = y1 - y0,
-    dx02 = x2 - x0,
-    dy02 = y2 - y0,
-    dx12 = x2 - x1,
-    dy12 = y2 - y1;
-  int
-    sa   = 0,
-    sb   = 0;
+  EdgeWalk l, s;          // long edge 0-2, short edge 0-1 then 1-2
+  SpanRun run;
+  int a, b, y;
 
   // Sort coordinates by Y order (y2 >= y1 >= y0)
   if (y0 > y1) {
@@ -318,103 +603,404 @@ void fillTriangle ( int x0, int y0,
     return;
   }
 
+  a = x0 < x1 ? (x0 < x2 ? x0 : x2) : (x1 < x2 ? x1 : x2);
+  b = x0 > x1 ? (x0 > x2 ? x0 : x2) : (x1 > x2 ? x1 : x2);
+  if (clipMisses(a, y0, b, y2)) return;
+
+  run.rows = 0;
+  run.color = color;
+  edgeStart(&l, x0, y0, x2, y2);
+  edgeStart(&s, x0, y0, x1, y1);
 
+  // rows above the clip rectangle are stepped over in one go
+  y = y0;
+  if (y < clipRect.y0) {
+    a = (clipRect.y0 < y1 ? clipRect.y0 : y1) - y0;
+    l.x += l.dx * a;
+    s.x += s.dx * a;
+    y += a;
+  }
 
-  // For upper part of triangle, find scanline crossings for segments
-  // 0-1 and 0-2.  If y1=y2 (flat-bottomed triangle), the scanline y1
-  // is included here (and second loop will be skipped, avoiding a /0
-  // error there), otherwise scanline y1 is skipped here and handled
-  // in the second loop...which also avoids a /0 error here if y0=y1
-  // (flat-topped triangle).
-  if(y1 == y2) last = y1;   // Include y1 scanline
-  else         last = y1-1; // Skip it
-
-  for(y=y0; y<=last; y++) {
-    a   = x0 + sa / dy01;
-    b   = x0 + sb / dy02;
-    sa += dx01;
-    sb += dx02;
-    /* longhand:
-    a = x0 + (x1 - x0) * (y - y0) / (y1 - y0);
-    b = x0 + (x2 - x0) * (y - y0) / (y2 - y0);
-    */
-    if(a > b) swap(a,b);
-    drawFastHLine(a, y, b-a+1, color);
-  }
-
-  // For lower part of triangle, find scanline crossings for segments
-  // 0-2 and 1-2.  This loop is skipped if y1=y2.
-  sa = dx12 * (y - y1);
-  sb = dx02 * (y - y0);
-  for(; y<=y2; y++) {
-    a   = x1 + sa / dy12;
-    b   = x0 + sb / dy02;
-    sa += dx12;
-    sb += dx02;
-    /* longhand:
-    a = x1 + (x2 - x1) * (y - y1) / (y2 - y1);
-    b = x0 + (x2 - x0) * (y - y0) / (y2 - y0);
-    */
-    if(a > b) swap(a,b);
-    drawFastHLine(a, y, b-a+1, color);
+  for(; y<=y2 && y<=clipRect.y1; y++) {
+    // both short edges sit exactly on x1 at row y1, so switching there
+    // needs no correction (and covers the flat-topped case)
+    if(y == y1) edgeStart(&s, x1, y1, x2, y2);
+    if(y >= clipRect.y0) {
+      a = l.x >> 16;
+      b = s.x >> 16;
+      if(a > b) swap(a,b);
+      spanAdd(&run, y, a, b);
+    }
+    l.x += l.dx;
+    s.x += s.dx;
   }
+  spanFlush(&run);
 }
-/*
-void drawBitmap(int x, int y,
-			      const unsigned char *bitmap, int w, int h,
-			      unsigned int color) {
 
-  int i, j, byteWidth = (w + 7) / 8;
+//*****************************************************************************
+// Polygon filler.  Edges are sorted into an edge table by their top row and
+// moved into the active list as the scanline reaches them; each edge covers
+// rows top <= y < bottom so a vertex in the middle of a side is only
+// crossed once.  Spans between crossing pairs (even-odd rule) are merged
+// with the horizontal edges and vertices on the row, which keeps the bottom
+// edge and the tips inclusive like fillTriangle() without drawing any
+// pixel twice.
+//*****************************************************************************
+
+typedef struct {
+  EdgeWalk w;
+  int top, bottom;
+} PolyEdge;
+
+static void rowInsert(int *x0s, int *x1s, int *n, int x0, int x1) {
+  int i = *n;
+
+  while (i > 0 && x0s[i-1] > x0) {
+    x0s[i] = x0s[i-1];
+    x1s[i] = x1s[i-1];
+    i--;
+  }
+  x0s[i] = x0;
+  x1s[i] = x1;
+  (*n)++;
+}
+
+// Fill a closed polygon of n vertices (at most POLY_MAX_VERTS), given as
+// separate x and y arrays.  Concave and self-intersecting outlines are
+// filled by the even-odd rule.
+void fillPolygon(const int *xs, const int *ys, int n, unsigned int color) {
+  PolyEdge et[POLY_MAX_VERTS];
+  int act[POLY_MAX_VERTS];
+  int x0s[2*POLY_MAX_VERTS], x1s[2*POLY_MAX_VERTS];
+  SpanRun run;
+  PolyEdge e;
+  int edges = 0, next = 0, nact = 0, spans;
+  int i, j, k, y, yTop, yBottom, xLeft, xRight, xa, xb, ya, yb;
+
+  if (n < 1 || n > POLY_MAX_VERTS) return;
+
+  // edge table, sorted by top row
+  yTop = yBottom = ys[0];
+  xLeft = xRight = xs[0];
+  for (i = 0; i < n; i++) {
+    j = i + 1 < n ? i + 1 : 0;
+    if (ys[i] < yTop) yTop = ys[i];
+    if (ys[i] > yBottom) yBottom = ys[i];
+    if (xs[i] < xLeft) xLeft = xs[i];
+    if (xs[i] > xRight) xRight = xs[i];
+    if (ys[i] == ys[j]) continue;
+    if (ys[i] < ys[j]) { xa = xs[i]; ya = ys[i]; xb = xs[j]; yb = ys[j]; }
+    else               { xa = xs[j]; ya = ys[j]; xb = xs[i]; yb = ys[i]; }
+    edgeStart(&e.w, xa, ya, xb, yb);
+    e.top = ya;
+    e.bottom = yb;
+    for (k = edges; k > 0 && et[k-1].top > ya; k--)
+      et[k] = et[k-1];
+    et[k] = e;
+    edges++;
+  }
+
+  if (clipMisses(xLeft, yTop, xRight, yBottom)) return;
+  if (yTop < clipRect.y0) yTop = clipRect.y0;
+  if (yBottom > clipRect.y1) yBottom = clipRect.y1;
+
+  run.rows = 0;
+  run.color = color;
+  for (y = yTop; y <= yBottom; y++) {
+    // retire finished edges, then activate the ones that reach this row
+    for (i = k = 0; i < nact; i++)
+      if (et[act[i]].bottom > y)
+        act[k++] = act[i];
+    nact = k;
+    for (; next < edges && et[next].top <= y; next++) {
+      if (et[next].bottom <= y) continue;
+      if (et[next].top < y)   // polygon starts above the screen
+        et[next].w.x += et[next].w.dx * (long)(y - et[next].top);
+      act[nact++] = next;
+    }
+
+    // crossings in x order, paired up into spans
+    for (i = 1; i < nact; i++) {
+      k = act[i];
+      for (j = i; j > 0 && et[act[j-1]].w.x > et[k].w.x; j--)
+        act[j] = act[j-1];
+      act[j] = k;
+    }
+    spans = 0;
+    for (i = 0; i + 1 < nact; i += 2)
+      rowInsert(x0s, x1s, &spans, et[act[i]].w.x >> 16, et[act[i+1]].w.x >> 16);
+
+    // horizontal edges and vertices on this row
+    for (i = 0; i < n; i++) {
+      if (ys[i] != y) continue;
+      j = i + 1 < n ? i + 1 : 0;
+      if (ys[j] == y) {
+        xa = xs[i] < xs[j] ? xs[i] : xs[j];
+        xb = xs[i] < xs[j] ? xs[j] : xs[i];
+        rowInsert(x0s, x1s, &spans, xa, xb);
+      } else {
+        rowInsert(x0s, x1s, &spans, xs[i], xs[i]);
+      }
+    }
+
+    // merge overlapping and touching spans
+    for (i = 0, k = 0; i < spans; i++) {
+      if (k > 0 && x0s[i] <= x1s[k-1] + 1) {
+        if (x1s[i] > x1s[k-1]) x1s[k-1] = x1s[i];
+      } else {
+        x0s[k] = x0s[i];
+        x1s[k] = x1s[i];
+        k++;
+      }
+    }
 
-  for(j=0; j<h; j++) {
-    for(i=0; i<w; i++ ) {
-      if(pgm_read_byte(bitmap + j * byteWidth + i / 8) & (128 >> (i & 7))) {
-        drawPixel(x+i, y+j, color);
+    if (k == 1) {
+      spanAdd(&run, y, x0s[0], x1s[0]);
+    } else {
+      spanFlush(&run);
+      for (i = 0; i < k; i++) {
+        spanAdd(&run, y, x0s[i], x1s[i]);
+        spanFlush(&run);
       }
     }
+
+    for (i = 0; i < nact; i++)
+      et[act[i]].w.x += et[act[i]].w.dx;
   }
+  spanFlush(&run);
 }
-*/
-// Draw a 1-bit color bitmap at the specified x, y position from the
-// provided bitmap buffer (must be PROGMEM memory) using color as the
-// foreground color and bg as the background color.
-/*
-void drawBitmap(int x, int y,
-            const unsigned char *bitmap, int w, int h,
-            unsigned int color, unsigned int bg) {
 
-  int i, j, byteWidth = (w + 7) / 8;
-  
-  for(j=0; j<h; j++) {
-    for(i=0; i<w; i++ ) {
-      if(pgm_read_byte(bitmap + j * byteWidth + i / 8) & (128 >> (i & 7))) {
-        drawPixel(x+i, y+j, color);
-      }
-      else {
-      	drawPixel(x+i, y+j, bg);
+//*****************************************************************************
+// Image blitters.  The visible part of an image is clipped once up front and
+// streamed as one window burst, the pixels following on row by row; off
+// screen pixels are decoded and dropped without reaching the bus.  A
+// buffered or display list build cannot take a burst, so there the same
+// pixels go through fillRect() as runs of one colour along each row.
+//*****************************************************************************
+
+#if defined(SSD1351_FRAMEBUFFER) || defined(SSD1351_STRIPBUFFER) || defined(SSD1351_DISPLAYLIST)
+#define BLIT_RUNS
+#endif
+
+// An indexed framebuffer takes palette indices, so the RGB565 colours of an
+// image are matched to the palette on the way in
+#ifdef SSD1351_INDEXED
+#define IMAGE_COLOR(c)  displayMatchColor(c)
+#else
+#define IMAGE_COLOR(c)  (c)
+#endif
+
+typedef struct {
+  int x, y, w;            // image position and width
+  int cx0, cx1, cy0, cy1; // visible part, inclusive image coordinates
+  int i, j;               // image pixel the next one written lands on
+} Blit;
+
+// Returns 0 if none of the image is on screen
+static int blitBegin(Blit *b, int x, int y, int w, int h) {
+  b->x = x;
+  b->y = y;
+  b->w = w;
+  b->cx0 = x < clipRect.x0 ? clipRect.x0 - x : 0;
+  b->cy0 = y < clipRect.y0 ? clipRect.y0 - y : 0;
+  b->cx1 = x + w - 1 > clipRect.x1 ? clipRect.x1 - x : w - 1;
+  b->cy1 = y + h - 1 > clipRect.y1 ? clipRect.y1 - y : h - 1;
+  b->i = b->j = 0;
+  if (w <= 0 || h <= 0 || b->cx0 > b->cx1 || b->cy0 > b->cy1)
+    return 0;
+
+#ifndef BLIT_RUNS
+  startWrite();
+  setAddrWindow(x + b->cx0, y + b->cy0, b->cx1 - b->cx0 + 1, b->cy1 - b->cy0 + 1);
+#endif
+  return 1;
+}
+
+static void blitEnd(void) {
+#ifndef BLIT_RUNS
+  endWrite();
+#endif
+}
+
+// Nonzero once every visible row has been written
+static int blitDone(const Blit *b) {
+  return b->j > b->cy1;
+}
+
+// The part of the next n pixels of the current row that is visible: returns
+// how many pixels to step over and sets *first/*count to the visible ones.
+static int blitClipRow(const Blit *b, long n, int *first, int *count) {
+  int run = b->w - b->i;
+  int a, e;
+
+  if (n < run) run = n;
+  a = b->i > b->cx0 ? b->i : b->cx0;
+  e = b->i + run - 1 < b->cx1 ? b->i + run - 1 : b->cx1;
+  *first = a - b->i;
+  *count = (b->j >= b->cy0 && a <= e) ? e - a + 1 : 0;
+  return run;
+}
+
+static void blitStep(Blit *b, int run) {
+  b->i += run;
+  if (b->i == b->w) {
+    b->i = 0;
+    b->j++;
+  }
+}
+
+// n pixels of one colour, in raster order
+static void blitColor(Blit *b, unsigned int color, long n) {
+  int run, first, count;
+
+  while (n > 0 && !blitDone(b)) {
+    run = blitClipRow(b, n, &first, &count);
+    if (count) {
+#ifdef BLIT_RUNS
+      fillRect(b->x + b->i + first, b->y + b->j, count, 1, color);
+#else
+      writeColor(color, count);
+#endif
+    }
+    blitStep(b, run);
+    n -= run;
+  }
+}
+
+// n pixels taken from p, in raster order
+static void blitPixels(Blit *b, const unsigned short *p, long n) {
+  int run, first, count;
+
+  while (n > 0 && !blitDone(b)) {
+    run = blitClipRow(b, n, &first, &count);
+    if (count) {
+#ifdef BLIT_RUNS
+      const unsigned short *q = p + first;
+      int k, x = b->x + b->i + first;
+
+      while (count) {
+        for (k = 1; k < count && q[k] == q[0]; k++)
+          ;
+        fillRect(x, b->y + b->j, k, 1, IMAGE_COLOR(q[0]));
+        x += k;
+        q += k;
+        count -= k;
       }
+#else
+      writePixels(p + first, count);
+#endif
     }
+    blitStep(b, run);
+    p += run;
+    n -= run;
   }
 }
 
+static int bitAt(const unsigned char *row, int i, int lsbFirst) {
+  return lsbFirst ? (row[i / 8] >> (i & 7)) & 1 : (row[i / 8] >> (7 - (i & 7))) & 1;
+}
+
+// Walk a 1-bpp image as runs of set and clear bits along each row.  With
+// opaque set both colours go into one burst; otherwise only the set runs
+// are drawn, as clipped horizontal runs.
+static void bitmapRuns(int x, int y, const unsigned char *bitmap, int w, int h,
+               unsigned int color, unsigned int bg, int opaque, int lsbFirst) {
+  int byteWidth = (w + 7) / 8;
+  const unsigned char *row;
+  int i, j, k, bit;
+  int j0 = y < clipRect.y0 ? clipRect.y0 - y : 0;   // rows above are never walked
+  Blit b;
+
+  if (opaque) {
+    if (!blitBegin(&b, x, y, w, h))
+      return;
+    b.j = j0;
+  } else if (w <= 0 || h <= 0 || clipMisses(x, y, x + w - 1, y + h - 1)) {
+    return;
+  }
+
+  for (j = j0; j < h && y + j <= clipRect.y1; j++) {
+    row = bitmap + j * byteWidth;
+    for (i = 0; i < w; i = k) {
+      bit = bitAt(row, i, lsbFirst);
+      for (k = i + 1; k < w && bitAt(row, k, lsbFirst) == bit; k++)
+        ;
+      if (opaque)
+        blitColor(&b, bit ? color : bg, k - i);
+      else if (bit)
+        drawFastHLine(x + i, y + j, k - i, color);
+    }
+  }
+
+  if (opaque)
+    blitEnd();
+}
+
+// Draw a 1-bit bitmap at the specified x, y position, MSB first within each
+// byte and rows padded to whole bytes.  Clear bits are left untouched.
+void drawBitmap(int x, int y,
+			      const unsigned char *bitmap, int w, int h,
+			      unsigned int color) {
+  bitmapRuns(x, y, bitmap, w, h, color, 0, 0, 0);
+}
+
+// Same, with clear bits drawn in bg so the whole image is one burst
+void drawBitmapBg(int x, int y,
+            const unsigned char *bitmap, int w, int h,
+            unsigned int color, unsigned int bg) {
+  bitmapRuns(x, y, bitmap, w, h, color, bg, 1, 0);
+}
+
 //Draw XBitMap Files (*.xbm), exported from GIMP,
 //Usage: Export from GIMP to *.xbm, rename *.xbm to *.c and open in editor.
 //C Array can be directly used with this function
 void drawXBitmap(int x, int y,
                               const unsigned char *bitmap, int w, int h,
                               unsigned int color) {
-  
-  int i, j, byteWidth = (w + 7) / 8;
-  
-  for(j=0; j<h; j++) {
-    for(i=0; i<w; i++ ) {
-      if(pgm_read_byte(bitmap + j * byteWidth + i / 8) & (1 << (i % 8))) {
-        drawPixel(x+i, y+j, color);
-      }
+  bitmapRuns(x, y, bitmap, w, h, color, 0, 0, 1);
+}
+
+// Draw w x h RGB565 pixels stored row by row
+void drawRGBBitmap(int x, int y, const unsigned short *pixels, int w, int h) {
+  Blit b;
+
+  if (!blitBegin(&b, x, y, w, h))
+    return;
+  // skip the rows above the screen without walking them
+  pixels += (long)b.cy0 * w;
+  b.j = b.cy0;
+  blitPixels(&b, pixels, (long)w * (h - b.cy0));
+  blitEnd();
+}
+
+// Draw a run-length encoded RGB565 image (see RLE_LITERAL).  Runs may cross
+// row ends; decoding stops after w x h pixels, at the last visible row or at
+// a header with a count of 0.
+void drawRLEBitmap(int x, int y, const unsigned short *rle, int w, int h) {
+  long left = (long)w * h;
+  unsigned int n;
+  Blit b;
+
+  if (!blitBegin(&b, x, y, w, h))
+    return;
+  while (left > 0 && !blitDone(&b)) {
+    n = *rle & ~RLE_LITERAL;
+    if (n == 0)
+      break;
+    if (n > left) n = left;
+    if (*rle++ & RLE_LITERAL) {
+      blitPixels(&b, rle, n);
+      rle += n;
+    } else {
+      blitColor(&b, IMAGE_COLOR(*rle), n);
+      rle++;
     }
+    left -= n;
   }
+  blitEnd();
 }
 
+/*
 #if ARDUINO >= 100
 size_t write(unsigned char c) {
 #else
@@ -439,6 +1025,110 @@ void write(unsigned char c) {
 }
 */
 // Draw a character
+#if !defined(SSD1351_FRAMEBUFFER) && !defined(SSD1351_STRIPBUFFER)
+#ifdef SSD1351_GLYPHCACHE
+// Opaque glyph from the cache: on a hit the stored pixels go straight into
+// the burst, scaled up by repeating each one when size > 1.
+static void glyphBlitCached(int x, int y, unsigned char c,
+               unsigned int color, unsigned int bg, unsigned char size) {
+  const unsigned short *img = glyphCacheFind(c, color, bg);
+  const unsigned short *row;
+  unsigned short *fill;
+  unsigned char line;
+  int i, j, k;
+
+  if (!img) {
+    fill = glyphCacheInsert(c, color, bg);
+    for (i=0; i<6; i++) {
+      line = (i == 5) ? 0 : font[(c*5)+i];
+      for (j = 0; j<8; j++) {
+        fill[j*6 + i] = (line & 0x1) ? color : bg;
+        line >>= 1;
+      }
+    }
+    img = fill;
+  }
+
+  startWrite();
+  setAddrWindow(x, y, 6*size, 8*size);
+  if (size == 1) {
+    writePixels(img, GLYPH_PIXELS);
+  } else {
+    for (j = 0; j<8; j++) {
+      row = &img[j*6];
+      for (k = 0; k<size; k++)
+        for (i=0; i<6; i++)
+          writeColor(row[i], size);
+    }
+  }
+  endWrite();
+}
+#endif
+
+// Opaque glyph as a single window: 6*size x 8*size pixels streamed row by
+// row, with neighbouring pixels of the same color sent as one writeColor().
+static void glyphBlit(int x, int y, unsigned char c,
+               unsigned int color, unsigned int bg, unsigned char size) {
+#ifdef SSD1351_GLYPHCACHE
+  glyphBlitCached(x, y, c, color, bg, size);
+#else
+  unsigned char cols[6];
+  unsigned int run, pix;
+  unsigned long n;
+  int i, j, k;
+
+  for (i=0; i<5; i++)
+    cols[i] = font[(c*5)+i];
+  cols[5] = 0;
+
+  startWrite();
+  setAddrWindow(x, y, 6*size, 8*size);
+  for (j = 0; j<8; j++) {
+    for (k = 0; k<size; k++) {
+      run = (cols[0] >> j) & 1 ? color : bg;
+      n = 0;
+      for (i=0; i<6; i++) {
+        pix = (cols[i] >> j) & 1 ? color : bg;
+        if (pix != run) {
+          writeColor(run, n);
+          run = pix;
+          n = 0;
+        }
+        n += size;
+      }
+      writeColor(run, n);
+    }
+  }
+  endWrite();
+#endif
+}
+#endif
+
+// Glyph as vertical runs, one fillRect() per run of set bits in a column
+// (and per run of clear bits when the background is drawn).
+static void glyphRuns(int x, int y, unsigned char c,
+               unsigned int color, unsigned int bg, unsigned char size) {
+  unsigned char line;
+  int i, j, start;
+
+  for (i=0; i<6; i++) {
+    line = (i == 5) ? 0 : font[(c*5)+i];
+    for (j = 0; j<8; j = start) {
+      start = j;
+      while (start < 8 && ((line >> start) & 1) == ((line >> j) & 1))
+        start++;
+      if ((line >> j) & 1)
+        fillRect(x+i*size, y+j*size, size, (start-j)*size, color);
+      else if (bg != color)
+        fillRect(x+i*size, y+j*size, size, (start-j)*size, bg);
+    }
+  }
+}
+
+const unsigned char *glyphColumns(unsigned char c) {
+  return &font[c*5];
+}
+
 void drawChar(int x, int y, unsigned char c,
 			    unsigned int color, unsigned int bg, unsigned char size) {
 
@@ -446,12 +1136,34 @@ void drawChar(int x, int y, unsigned char c,
   char i;
   char j;
 
-  if((x >= WIDTH)            || // Clip right
-     (y >= HEIGHT)           || // Clip bottom
-     ((x + 6 * size - 1) < 0) || // Clip left
-     ((y + 8 * size - 1) < 0))   // Clip top
+  if (clipMisses(x, y, x + 6 * size - 1, y + 8 * size - 1))
     return;
 
+  // Glyphs that are entirely inside the clip rectangle go out as one window
+  // burst when opaque, or as column runs when transparent.  A framebuffer
+  // build draws runs either way, since bursts would bypass the buffer.  The
+  // strip renderer and the display list record the whole glyph as one op.
+  if (x >= clipRect.x0 && y >= clipRect.y0 &&
+      x + 6*size - 1 <= clipRect.x1 && y + 8*size - 1 <= clipRect.y1) {
+#ifdef SSD1351_DISPLAYLIST
+    if (listGlyph(x, y, c, color, bg, size))
+      return;
+#endif
+#ifdef SSD1351_STRIPBUFFER
+    if (stripGlyph(x, y, c, color, bg, size))
+      return;
+#endif
+#if !defined(SSD1351_FRAMEBUFFER) && !defined(SSD1351_STRIPBUFFER)
+    if (bg != color) {
+      glyphBlit(x, y, c, color, bg, size);
+      return;
+    }
+#endif
+    glyphRuns(x, y, c, color, bg, size);
+    return;
+  }
+
+  // partly clipped: pixel by pixel, so each one is clipped
   for (i=0; i<6; i++ ) {
     if (i == 5) 
       line = 0x0;
@@ -511,14 +1223,19 @@ void setTextColor(unsigned int c, unsigned int b) {
 void setTextWrap(char w) {
   wrap = w;
 }
-/*
+
 unsigned char getRotation(void) {
   return rotation;
 }
 
-
+// Rotation is done by the controller's remap register, so drawing code
+// never transforms coordinates; only width() and height() change.  Clear
+// the screen afterwards, since what is in GRAM now shows rotated.
 void setRotation(unsigned char x) {
   rotation = (x & 3);
+#if (WIDTH != HEIGHT) && (defined(SSD1351_FRAMEBUFFER) || defined(SSD1351_STRIPBUFFER))
+  rotation &= 2;    // the buffers are laid out for the unrotated panel
+#endif
   switch(rotation) {
    case 0:
    case 2:
@@ -531,18 +1248,30 @@ void setRotation(unsigned char x) {
     _height = WIDTH;
     break;
   }
+  clearClipRect();
+  setRemap(rotation);
+}
+
+// Confine drawing to the w x h viewport at x, y (kept within the screen).
+// Shapes are still positioned in screen coordinates.
+void setClipRect(int x, int y, int w, int h) {
+  clipRect.x0 = x < 0 ? 0 : x;
+  clipRect.y0 = y < 0 ? 0 : y;
+  clipRect.x1 = x + w > _width ? _width - 1 : x + w - 1;
+  clipRect.y1 = y + h > _height ? _height - 1 : y + h - 1;
+}
+
+void clearClipRect(void) {
+  setClipRect(0, 0, _width, _height);
 }
 
-*/
 // Return the size of the display (per current rotation)
 int width(void) {
-//  return _width;
-	return WIDTH;
+  return _width;
 }
  
 int height(void) {
-//  return _height;
-	return HEIGHT;
+  return _height;
 }
 
 
@@ -20,7 +20,11 @@
 #include "uart_if.h"
 #include "pinmux.h"
 
+#include "Adafruit_GFX.h"
 #include "Adafruit_SSD1351.h"
+#include "framebuffer.h"
+#include "stripbuffer.h"
+#include "displaylist.h"
 
 //*****************************************************************************
 
@@ -28,46 +32,202 @@
 #define OC  0x80
 
 
-void writeCommand(unsigned char c) {
+//*****************************************************************************
+//
+// Burst transfers
+//
+// A transaction asserts the OLED chip select once and keeps it asserted while
+// any number of command and data bytes are clocked out.  DC is only driven
+// when the byte type changes, so a WRITERAM payload streams back-to-back with
+// no GPIO traffic between pixels.
+//
+//*****************************************************************************
 
-//TODO 1
-/* Write a function to send a command byte c to the OLED via
-*  SPI.
-*/
+static unsigned char dcLevel = 0xFF;    // level last driven on DC (0xFF = unknown)
+static unsigned long rxPending;         // bytes clocked out but not yet read back
 
-    // set DC Control to low
-    unsigned long buffer;
-    SPICSEnable(GSPI_BASE);
-    GPIOPinWrite(GPIOA0_BASE, DC, 0);
-    GPIOPinWrite(GPIOA3_BASE, OC, 0);
+// Shadow of the controller's column/row window and RAM write pointer.  The
+// pointer only moves on SETCOLUMN/SETROW (each resets its own axis to the
+// window start) and on pixel data, so setAddrWindow() can tell when the next
+// write already lines up and leave the window commands out.
+static unsigned char winValid;          // shadow matches the controller
+static unsigned char ramWrite;          // WRITERAM was the last command
+static int winX0, winX1, winY0, winY1;
+static int ptrX, ptrY;
+
+// Odd rotations run the controller in vertical address increment mode with
+// the window axes swapped, so the shadow above stays in screen coordinates
+// and pixels still arrive row by row of the rotated screen.
+static unsigned char swapXY;
+
+OledStats oledStats;
+
+static void spiPut(unsigned char c) {
+    unsigned long dummy;
 
     SPIDataPut(GSPI_BASE, c);
-    SPIDataGet(GSPI_BASE, &buffer);
+    rxPending++;
+    oledStats.bytes++;
 
-    GPIOPinWrite(GPIOA3_BASE, OC, OC);
-    SPICSDisable(GSPI_BASE);
+    // keep the receive side drained so the next put never stalls on it
+    while (rxPending && SPIDataGetNonBlocking(GSPI_BASE, &dummy))
+        rxPending--;
 }
-//*****************************************************************************
 
-void writeData(unsigned char c) {
+static void spiDrain(void) {
+    unsigned long dummy;
 
-//TODO 2
-/* Write a function to send a data byte c to the OLED via
-*  SPI.
-*/
-    // set DC Control to high
-    unsigned long buffer;
+    while (rxPending) {
+        SPIDataGet(GSPI_BASE, &dummy);
+        rxPending--;
+    }
+}
+
+static void setDC(unsigned char level) {
+    if (level == dcLevel)
+        return;
+
+    // DC is sampled with the last bit of a byte, so let the wire go idle first
+    spiDrain();
+    GPIOPinWrite(GPIOA0_BASE, DC, level);
+    dcLevel = level;
+}
+
+static void spiCommand(unsigned char c) {
+    ramWrite = 0;
+    oledStats.commands++;
+    setDC(0);
+    spiPut(c);
+}
+
+static void spiData(unsigned char c) {
+    setDC(DC);
+    spiPut(c);
+}
+
+void startWrite(void) {
+    oledStats.transactions++;
     SPICSEnable(GSPI_BASE);
-    GPIOPinWrite(GPIOA0_BASE, DC, DC);
     GPIOPinWrite(GPIOA3_BASE, OC, 0);
+}
 
-    SPIDataPut(GSPI_BASE, c);
-    SPIDataGet(GSPI_BASE, &buffer);
-
+void endWrite(void) {
+    spiDrain();
     GPIOPinWrite(GPIOA3_BASE, OC, OC);
     SPICSDisable(GSPI_BASE);
 }
 
+// Step the shadow write pointer over n pixels, wrapping like the controller
+static void advancePointer(unsigned long n) {
+    unsigned long w = winX1 - winX0 + 1;
+    unsigned long i = (ptrY - winY0) * w + (ptrX - winX0) + n;
+
+    i %= w * (winY1 - winY0 + 1);
+    ptrX = winX0 + i % w;
+    ptrY = winY0 + i / w;
+}
+
+// Must be called between startWrite() and endWrite().  Leaves the controller
+// in WRITERAM so the pixels for the window can follow directly.
+//
+// Only the parts of the window that differ are sent.  The row range always
+// runs to the bottom edge and a multi-column area gets its exact column
+// range, so a rect's pixels wrap row by row and a single column written top
+// to bottom keeps hitting the pointer.  A pixel that follows on along the
+// pointer's row opens the column range to the right edge instead, which lets
+// the next pixel along the row follow on too.
+void setAddrWindow(int x, int y, int w, int h) {
+    int x1 = x + w - 1;
+    int colOk, rowOk;
+
+    if (winValid) {
+        colOk = ptrX == x && (h == 1 ? x1 <= winX1 : winX0 == x && winX1 == x1);
+        rowOk = ptrY == y;
+    } else {
+        colOk = rowOk = 0;
+    }
+
+    if (!colOk) {
+        winX0 = x;
+        winX1 = (w == 1 && h == 1 && winValid && ptrY == y) ? width() - 1 : x1;
+        spiCommand(swapXY ? SSD1351_CMD_SETROW : SSD1351_CMD_SETCOLUMN);
+        spiData(winX0);
+        spiData(winX1);
+        ptrX = x;
+    }
+    if (!rowOk) {
+        winY0 = y;
+        winY1 = height() - 1;
+        spiCommand(swapXY ? SSD1351_CMD_SETCOLUMN : SSD1351_CMD_SETROW);
+        spiData(winY0);
+        spiData(winY1);
+        ptrY = y;
+    }
+    if (!ramWrite) {
+        spiCommand(SSD1351_CMD_WRITERAM);
+        ramWrite = 1;
+    }
+    winValid = 1;
+}
+
+// Stream len pixels of a single color into the current window
+void writeColor(unsigned int color, unsigned long len) {
+    unsigned char hi = color >> 8;
+    unsigned char lo = color;
+
+    advancePointer(len);
+    oledStats.pixels += len;
+    setDC(DC);
+    while (len--) {
+        spiPut(hi);
+        spiPut(lo);
+    }
+}
+
+// Stream len RGB565 pixels into the current window
+void writePixels(const unsigned short *colors, unsigned long len) {
+    advancePointer(len);
+    oledStats.pixels += len;
+    setDC(DC);
+    while (len--) {
+        spiPut(*colors >> 8);
+        spiPut(*colors++);
+    }
+}
+
+//*****************************************************************************
+
+// Raw commands and data bypass the window shadow and the strip renderer's
+// band hashes, so drop them
+void writeCommand(unsigned char c) {
+#if defined(SSD1351_DISPLAYLIST)
+    if (listWrite(c, 0))
+        return;
+#endif
+#if defined(SSD1351_STRIPBUFFER)
+    stripInvalidate();
+#endif
+    winValid = 0;
+    startWrite();
+    spiCommand(c);
+    endWrite();
+}
+//*****************************************************************************
+
+void writeData(unsigned char c) {
+#if defined(SSD1351_DISPLAYLIST)
+    if (listWrite(c, 1))
+        return;
+#endif
+#if defined(SSD1351_STRIPBUFFER)
+    stripInvalidate();
+#endif
+    winValid = 0;
+    startWrite();
+    spiData(c);
+    endWrite();
+}
+
 //*****************************************************************************
 void Adafruit_Init(void){
 
@@ -81,6 +241,14 @@ void Adafruit_Init(void){
 
     volatile unsigned long delay;
 
+#if defined(SSD1351_DISPLAYLIST)
+    // nothing queued may reach the panel after the reset
+    displayFence();
+#endif
+#if defined(SSD1351_DOUBLEBUFFER)
+    displayInvalidate();
+#endif
+
     GPIOPinWrite(GPIOA3_BASE, 0x10, 0);   // RESET = RESET_LOW
 
     for(delay=0; delay<100; delay=delay+1);// delay minimum 100 ns
@@ -101,8 +269,7 @@ void Adafruit_Init(void){
     writeCommand(SSD1351_CMD_MUXRATIO);
     writeData(127);
 
-    writeCommand(SSD1351_CMD_SETREMAP);
-    writeData(0x74);
+    setRemap(getRotation());
 
     writeCommand(SSD1351_CMD_SETCOLUMN);
     writeData(0x00);
@@ -111,14 +278,6 @@ void Adafruit_Init(void){
     writeData(0x00);
     writeData(0x7F);
 
-    writeCommand(SSD1351_CMD_STARTLINE);      // 0xA1
-    if (SSD1351HEIGHT == 96) {
-        writeData(96);
-    } else {
-        writeData(0);
-    }
-
-
     writeCommand(SSD1351_CMD_DISPLAYOFFSET);  // 0xA2
     writeData(0x0);
 
@@ -159,21 +318,51 @@ void Adafruit_Init(void){
     writeCommand(SSD1351_CMD_DISPLAYON);      //--turn on oled panel
 }
 
+// Program the remap register for one of the setRotation() orientations so
+// the controller does the transform.  Bit 0 selects vertical address
+// increment, bit 1 mirrors the columns and bit 4 flips the COM scan; the
+// colour order, split and 65k bits stay as the upright 0x74.  Also sends
+// STARTLINE, which the 1.27" panel needs offset in the upright pair.
+void setRemap(unsigned char r) {
+    static const unsigned char remap[4] = { 0x74, 0x77, 0x66, 0x65 };
+
+#if defined(SSD1351_DISPLAYLIST)
+    // swapXY must not change under the fills still queued ahead of this
+    if (listRemap(r))
+        return;
+#endif
+
+    r &= 3;
+    swapXY = r & 1;
+
+    writeCommand(SSD1351_CMD_SETREMAP);       // 0xA0
+    writeData(remap[r]);
+
+    writeCommand(SSD1351_CMD_STARTLINE);      // 0xA1
+    if (SSD1351HEIGHT == 96 && r < 2) {
+        writeData(96);
+    } else {
+        writeData(0);
+    }
+}
+
 /***********************************/
 
 void goTo(int x, int y) {
-    if ((x >= SSD1351WIDTH) || (y >= SSD1351HEIGHT)) return;
-
-    // set x and y coordinate
-    writeCommand(SSD1351_CMD_SETCOLUMN);
-    writeData(x);
-    writeData(SSD1351WIDTH-1);
+    if ((x >= width()) || (y >= height())) return;
 
-    writeCommand(SSD1351_CMD_SETROW);
-    writeData(y);
-    writeData(SSD1351HEIGHT-1);
+#if defined(SSD1351_DISPLAYLIST)
+    // the caller goes on to write to the panel itself
+    displayFence();
+#endif
+#if defined(SSD1351_STRIPBUFFER)
+    stripInvalidate();
+#endif
 
-    writeCommand(SSD1351_CMD_WRITERAM);
+    // set x and y coordinate
+    startWrite();
+    setAddrWindow(x, y, width()-x, height()-y);
+    endWrite();
 }
 
 unsigned int Color565(unsigned char r, unsigned char g, unsigned char b) {
@@ -187,8 +376,34 @@ unsigned int Color565(unsigned char r, unsigned char g, unsigned char b) {
     return c;
 }
 
+// Every primitive ends up here once its bounds are settled.  Depending on the
+// build the area is drawn into the framebuffer, recorded for the strip
+// renderer or the display list, or streamed to the panel as one window burst.
+static void fillArea(int x, int y, int w, int h, unsigned int color) {
+    if (w <= 0 || h <= 0)
+        return;
+
+#if defined(SSD1351_FRAMEBUFFER)
+    fbFillRect(x, y, w, h, color);
+#else
+#if defined(SSD1351_STRIPBUFFER)
+    if (stripFillRect(x, y, w, h, color))
+        return;
+#endif
+#if defined(SSD1351_DISPLAYLIST)
+    if (listFillRect(x, y, w, h, color))
+        return;
+#endif
+    // set location and fill!
+    startWrite();
+    setAddrWindow(x, y, w, h);
+    writeColor(color, (unsigned long)w*h);
+    endWrite();
+#endif
+}
+
 void fillScreen(unsigned int fillcolor) {
-  fillRect(0, 0, SSD1351WIDTH, SSD1351HEIGHT, fillcolor);
+  fillRect(0, 0, width(), height(), fillcolor);
 }
 
 
@@ -197,104 +412,40 @@ void fillScreen(unsigned int fillcolor) {
     @brief  Draws a filled rectangle using HW acceleration
 */
 /**************************************************************************/
-void fillRect(unsigned int x, unsigned int y, unsigned int w, unsigned int h, unsigned int fillcolor)
+void fillRect(int x, int y, int w, int h, unsigned int fillcolor)
 {
-    unsigned int i;
-
-      // Bounds check
-      if ((x >= SSD1351WIDTH) || (y >= SSD1351HEIGHT))
-          return;
-
-      // Y bounds check
-      if (y+h > SSD1351HEIGHT)
+      // Clip once against the clip rectangle.  Whatever is left is
+      // on screen, and an area with nothing left is dropped by fillArea().
+      if (x < clipRect.x0)
       {
-          h = SSD1351HEIGHT - y - 1;
+          w -= clipRect.x0 - x;
+          x = clipRect.x0;
       }
-
-      // X bounds check
-      if (x+w > SSD1351WIDTH)
+      if (y < clipRect.y0)
       {
-          w = SSD1351WIDTH - x - 1;
+          h -= clipRect.y0 - y;
+          y = clipRect.y0;
       }
-
-      // set location
-      writeCommand(SSD1351_CMD_SETCOLUMN);
-      writeData(x);
-      writeData(x+w-1);
-      writeCommand(SSD1351_CMD_SETROW);
-      writeData(y);
-      writeData(y+h-1);
-      // fill!
-      writeCommand(SSD1351_CMD_WRITERAM);
-
-      for (i=0; i < w*h; i++) {
-          writeData(fillcolor >> 8);
-          writeData(fillcolor);
+      if (x + w > clipRect.x1 + 1)
+      {
+          w = clipRect.x1 + 1 - x;
+      }
+      if (y + h > clipRect.y1 + 1)
+      {
+          h = clipRect.y1 + 1 - y;
       }
+
+      fillArea(x, y, w, h, fillcolor);
 }
 
 void drawFastVLine(int x, int y, int h, unsigned int color) {
-
-  unsigned int i;
-  // Bounds check
-  if ((x >= SSD1351WIDTH) || (y >= SSD1351HEIGHT))
-      return;
-
-  // X bounds check
-  if (y+h > SSD1351HEIGHT)
-  {
-      h = SSD1351HEIGHT - y - 1;
-  }
-
-  if (h < 0) return;
-
-  // set location
-  writeCommand(SSD1351_CMD_SETCOLUMN);
-  writeData(x);
-  writeData(x);
-  writeCommand(SSD1351_CMD_SETROW);
-  writeData(y);
-  writeData(y+h-1);
-  // fill!
-  writeCommand(SSD1351_CMD_WRITERAM);
-
-  for (i=0; i < h; i++) {
-      writeData(color >> 8);
-      writeData(color);
-  }
+  fillRect(x, y, 1, h, color);
 }
 
 
 
 void drawFastHLine(int x, int y, int w, unsigned int color) {
-
-    unsigned int i;
-    // Bounds check
-    if ((x >= SSD1351WIDTH) || (y >= SSD1351HEIGHT))
-        return;
-
-    // X bounds check
-    if (x+w > SSD1351WIDTH)
-    {
-        w = SSD1351WIDTH - x - 1;
-    }
-
-    if (w < 0) return;
-
-    // set location
-     writeCommand(SSD1351_CMD_SETCOLUMN);
-     writeData(x);
-     writeData(x+w-1);
-     writeCommand(SSD1351_CMD_SETROW);
-     writeData(y);
-     writeData(y);
-     // fill!
-     writeCommand(SSD1351_CMD_WRITERAM);
-
-     for (i=0; i < w; i++) {
-         writeData(color >> 8);
-         writeData(color);
-     }
+    fillRect(x, y, w, 1, color);
 }
 
 
@@ -302,13 +453,10 @@ void drawFastHLine(int x, int y, int w, unsigned int color) {
 
 void drawPixel(int x, int y, unsigned int color)
 {
-    if ((x >= SSD1351WIDTH) || (y >= SSD1351HEIGHT)) return;
-    if ((x < 0) || (y < 0)) return;
-
-    goTo(x, y);
+    if ((x < clipRect.x0) || (x > clipRect.x1)) return;
+    if ((y < clipRect.y0) || (y > clipRect.y1)) return;
 
-    writeData(color >> 8);
-    writeData(color);
+    fillArea(x, y, 1, 1, color);
 }
 
 
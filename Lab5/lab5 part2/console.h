@@ -0,0 +1,45 @@
+//*****************************************************************************
+//
+// console.h
+//
+// Scrolling text console for the messaging screens.  The panel is split
+// into CONSOLE_ROWS lines of CONSOLE_COLS characters: the bottom line is
+// the input line being edited, everything above it is history.
+//
+// New lines scroll the whole display up by one text line through the
+// SSD1351 STARTLINE register, so a scroll costs two command bytes plus the
+// line that is redrawn, instead of a full screen redraw.  Because of that,
+// console text is drawn at GRAM rows that move as the console scrolls; use
+// consoleInputY() rather than a fixed y for anything on the input line.
+//
+// STARTLINE scrolls along the panel's COM lines, which are screen rows
+// only in rotations 0 and 2, and setRotation() resets it, so pick the
+// rotation before consoleInit() and keep the panel upright or upside down.
+//
+//*****************************************************************************
+
+#ifndef _CONSOLE_H
+#define _CONSOLE_H
+
+#include "Adafruit_SSD1351.h"
+
+#define CONSOLE_COLS    (SSD1351WIDTH / 6)
+#define CONSOLE_ROWS    (SSD1351HEIGHT / 8)
+
+// Clear the screen and reset the scroll position
+void consoleInit(unsigned int fg, unsigned int bg);
+
+// GRAM row of the top of the input line
+int consoleInputY(void);
+
+// Draw c in the input line at pixel column x (a multiple of 6); ' ' erases
+void consoleInputPut(int x, char c);
+
+// Move the input line into the history and start an empty one
+void consoleNewline(void);
+
+// Add text to the history above the input line, wrapping at CONSOLE_COLS;
+// the input line is redrawn below it
+void consolePrint(const char *s, unsigned int color);
+
+#endif // _CONSOLE_H
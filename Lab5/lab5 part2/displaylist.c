@@ -0,0 +1,192 @@
+//*****************************************************************************
+//
+// displaylist.c
+//
+// The ring has one producer, the drawing code, and one consumer, whichever
+// context calls displayDrain().  The producer fills a slot before advancing
+// head and the consumer runs an op before advancing tail, so neither index
+// is written by both sides.  The slots are volatile like the indices, so the
+// compiler cannot move a slot's stores past the head++ that publishes it,
+// or a slot's loads past the tail++ that hands it back.  A drain that interrupts another drain returns
+// at once instead of interleaving with its window burst.
+//
+// Ops are replayed through the ordinary drawing calls with the replaying
+// flag set, which sends them to the panel instead of back into the ring.
+// Fills were clipped when they were recorded, so replay opens the clip
+// rectangle to the whole panel; a setRotation() still waiting in the ring
+// must not cut off the ops queued ahead of it.
+//
+// A large fill is sent LIST_SLICE_PIXELS at a time: the slice is taken off
+// the top of the op, which stays at the tail until its last rows are sent.
+// The slot belongs to the consumer until tail moves past it, so shrinking
+// it in place is safe.
+//
+//*****************************************************************************
+
+#include "Adafruit_GFX.h"
+#include "Adafruit_SSD1351.h"
+#include "displaylist.h"
+
+#ifdef SSD1351_DISPLAYLIST
+
+#define PANEL_SIZE  (SSD1351WIDTH > SSD1351HEIGHT ? SSD1351WIDTH : SSD1351HEIGHT)
+
+enum {
+    OP_FILL,
+    OP_GLYPH,
+    OP_COMMAND,
+    OP_DATA,
+    OP_REMAP
+};
+
+typedef struct {
+    unsigned char kind;
+    unsigned char x, y;     // position, or the byte of a command/data op
+    unsigned char w, h;     // fill size, or glyph character and text size
+    unsigned short color;
+    unsigned short bg;
+} ListOp;
+
+static volatile ListOp ring[LIST_MAX_OPS];
+static volatile unsigned long head;     // next slot the producer fills
+static volatile unsigned long tail;     // next slot the consumer runs
+static volatile unsigned char draining;
+static unsigned char replaying;
+
+DisplayListStats displayListStats;
+
+static void runOp(const volatile ListOp *op) {
+    switch (op->kind) {
+    case OP_FILL:
+        fillRect(op->x, op->y, op->w, op->h, op->color);
+        break;
+    case OP_GLYPH:
+        drawChar(op->x, op->y, op->w, op->color, op->bg, op->h);
+        break;
+    case OP_COMMAND:
+        writeCommand(op->x);
+        break;
+    case OP_DATA:
+        writeData(op->x);
+        break;
+    case OP_REMAP:
+        setRemap(op->x);
+        break;
+    }
+}
+
+int displayDrain(int maxOps) {
+    ClipRect saved;
+
+    if (draining)
+        return head - tail;
+    draining = 1;
+    replaying = 1;
+
+    saved = clipRect;
+    clipRect.x0 = clipRect.y0 = 0;
+    clipRect.x1 = clipRect.y1 = PANEL_SIZE - 1;
+
+    while (maxOps-- > 0 && tail != head) {
+        volatile ListOp *op = &ring[tail & (LIST_MAX_OPS - 1)];
+        int rows;
+
+        if (op->kind == OP_FILL && op->w * op->h > LIST_SLICE_PIXELS) {
+            rows = LIST_SLICE_PIXELS / op->w;
+            if (rows == 0)
+                rows = 1;
+            fillRect(op->x, op->y, op->w, rows, op->color);
+            op->y += rows;
+            op->h -= rows;
+            continue;
+        }
+
+        runOp(op);
+        tail++;
+        displayListStats.drained++;
+    }
+
+    clipRect = saved;
+    replaying = 0;
+    draining = 0;
+    return head - tail;
+}
+
+void displayFence(void) {
+    while (displayDrain(LIST_MAX_OPS))
+        ;
+}
+
+// Claim the next slot, making room first if the consumer has fallen behind
+static volatile ListOp *listPut(unsigned char kind) {
+    unsigned long depth;
+    volatile ListOp *op;
+
+    while (head - tail >= LIST_MAX_OPS) {
+        displayListStats.stalls++;
+        displayDrain(1);
+    }
+
+    op = &ring[head & (LIST_MAX_OPS - 1)];
+    op->kind = kind;
+
+    depth = head - tail + 1;
+    if (depth > displayListStats.maxDepth)
+        displayListStats.maxDepth = depth;
+    displayListStats.recorded++;
+    return op;
+}
+
+int listFillRect(int x, int y, int w, int h, unsigned int color) {
+    volatile ListOp *op;
+
+    if (replaying)
+        return 0;
+
+    op = listPut(OP_FILL);
+    op->x = x;
+    op->y = y;
+    op->w = w;
+    op->h = h;
+    op->color = color;
+    head++;
+    return 1;
+}
+
+int listGlyph(int x, int y, unsigned char c, unsigned int color,
+              unsigned int bg, unsigned char size) {
+    volatile ListOp *op;
+
+    if (replaying)
+        return 0;
+
+    op = listPut(OP_GLYPH);
+    op->x = x;
+    op->y = y;
+    op->w = c;
+    op->h = size;
+    op->color = color;
+    op->bg = bg;
+    head++;
+    return 1;
+}
+
+int listWrite(unsigned char byte, int isData) {
+    if (replaying)
+        return 0;
+
+    listPut(isData ? OP_DATA : OP_COMMAND)->x = byte;
+    head++;
+    return 1;
+}
+
+int listRemap(unsigned char rotation) {
+    if (replaying)
+        return 0;
+
+    listPut(OP_REMAP)->x = rotation;
+    head++;
+    return 1;
+}
+
+#endif // SSD1351_DISPLAYLIST
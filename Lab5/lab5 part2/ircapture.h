@@ -0,0 +1,51 @@
+//*****************************************************************************
+//
+// ircapture.h
+//
+// IR receiver front end.  The receiver output drives a timer capture pin
+// (GT_CCP) and the timer latches its count on every edge in hardware, so
+// each pulse is measured to one 12.5 ns tick and the only interrupts are
+// the edges themselves plus a reload every 210 ms.
+//
+// The edge interrupt pushes each pulse width into a single-producer,
+// single-consumer ring; the main loop takes them out with irRead() at its
+// own pace.  The receiver output is low while IR is seen, so a mark is a
+// low pulse and a space a high one.
+//
+// RAM: 4 bytes per pulse, 512 bytes as configured.
+//
+//*****************************************************************************
+
+#ifndef _IRCAPTURE_H
+#define _IRCAPTURE_H
+
+#define IR_RING_SIZE        128             // pulses held, a power of two
+#define IR_TICKS_PER_US     80              // timer clock, 80 MHz
+
+#define IR_MARK             0x80000000UL    // set for a mark, clear for a space
+#define IR_GAP              0x00FFFFFFUL    // the widest pulse (see irRead())
+
+#define IR_WIDTH(p)         ((p) & IR_GAP)
+#define IR_IS_MARK(p)       (((p) & IR_MARK) != 0)
+#define IR_US(us)           ((unsigned long)(us) * IR_TICKS_PER_US)
+
+typedef struct {
+    unsigned long edges;        // edges captured
+    unsigned long overruns;     // pulses dropped because the ring was full
+    unsigned long maxDepth;     // most pulses waiting at once
+} IRCaptureStats;
+
+extern IRCaptureStats irCaptureStats;
+
+// Start capturing on timer A of timerBase (TIMERA0_BASE .. TIMERA3_BASE).
+// The receiver pin must already be muxed to that timer's GT_CCP input and
+// the timer clock enabled.
+void irCaptureInit(unsigned long timerBase);
+
+// Take the oldest pulse out of the ring; returns 0 if there is none.  A
+// width of IR_GAP means the line was idle for a whole timer period, or
+// that pulses before this one were lost to an overrun: either way any
+// frame in progress is over.
+int irRead(unsigned long *pulse);
+
+#endif // _IRCAPTURE_H
@@ -0,0 +1,58 @@
+//*****************************************************************************
+//
+// irdecode.h
+//
+// IR remote decoding for whatever remote is at hand.  Every pulse from
+// irRead() goes to one state machine per supported protocol; the first
+// machine to complete and validate a frame reports it and the others start
+// over.  Each pulse costs constant work per protocol.
+//
+// The protocols are described by a table of timings and bit codings in
+// irdecode.c:
+//
+//   NEC     9 ms leader, 32 bits LSB first as the space after each mark,
+//           with 2.25 ms repeat frames while a key is held
+//   RC-5    14 Manchester coded bits of 1.778 ms, MSB first, no leader
+//   SIRC    2.4 ms leader, 12, 15 or 20 bits LSB first as the mark width
+//
+// A SIRC frame has no stop bit, so it is only known to be complete when
+// the space after its last mark turns out to be longer than a bit; the
+// remote sends every frame at least three times, so that is the next one.
+//
+//*****************************************************************************
+
+#ifndef _IRDECODE_H
+#define _IRDECODE_H
+
+enum {
+    IR_NEC,
+    IR_RC5,
+    IR_SIRC,
+    IR_PROTOCOLS
+};
+
+typedef struct {
+    unsigned char protocol;     // IR_NEC, IR_RC5 or IR_SIRC
+    unsigned char repeat;       // the same frame again while a key is held
+    unsigned int address;       // NEC 8 or 16 bits, RC-5 5, SIRC 5 to 13
+    unsigned int command;       // NEC 8 bits, RC-5 and SIRC 7
+} IRCode;
+
+typedef struct {
+    unsigned long decoded[IR_PROTOCOLS];    // frames reported, repeats included
+    unsigned long rejected[IR_PROTOCOLS];   // complete frames that failed a check
+} IRDecodeStats;
+
+extern IRDecodeStats irDecodeStats;
+
+// Forget any frame in progress and the held key
+void irDecodeInit(void);
+
+// Take one pulse from irRead(); returns 1 and fills code when it completes
+// a frame in any protocol
+int irDecode(unsigned long pulse, IRCode *code);
+
+// "NEC", "RC5" or "SIRC"
+const char *irProtocolName(unsigned int protocol);
+
+#endif // _IRDECODE_H
@@ -0,0 +1,250 @@
+//*****************************************************************************
+//
+// keymap.c
+//
+// A code is packed into 32 bits (protocol, 16-bit address, command) and
+// hashed multiplicatively to its first slot; collisions go on to the next
+// slot.  The table is never more than three quarters full, so every probe
+// sequence ends at an empty slot within a few steps.  Bindings are only
+// ever added or rebound, never removed one at a time, so no tombstones are
+// needed.
+//
+// The saved file holds a header and then the bindings as a list of
+// (code, key) records rather than the slots, so a table saved by one build
+// loads into another with a different size; a build with a smaller limit
+// keeps the bindings that fit.  The file is created with room for this
+// build's KEYMAP_LIMIT records, and made again when a build with a larger
+// limit saves.
+//
+//*****************************************************************************
+
+#include "keymap.h"
+
+#ifdef KEYMAP_FLASH
+#include "simplelink.h"
+
+#define KEYMAP_FILE     "irkeymap.bin"
+#define KEYMAP_MAGIC    0x4B524931UL    // "1IRK"
+
+typedef struct {
+    unsigned long magic;
+    unsigned long count;        // records that follow
+} KeymapHeader;
+
+typedef struct {
+    unsigned long code;
+    unsigned long key;
+} KeymapRecord;
+
+#define KEYMAP_FILE_SIZE (sizeof(KeymapHeader) + KEYMAP_LIMIT * sizeof(KeymapRecord))
+#endif
+
+// The lab remote
+#define LAB_ADDRESS     0x40
+
+static const struct {
+    unsigned char command, key;
+} labRemote[] = {
+    { 0x00, KEY_0 }, { 0x01, KEY_1 }, { 0x02, KEY_2 }, { 0x03, KEY_3 },
+    { 0x04, KEY_4 }, { 0x05, KEY_5 }, { 0x06, KEY_6 }, { 0x07, KEY_7 },
+    { 0x08, KEY_8 }, { 0x09, KEY_9 }, { 0x40, KEY_DELETE }, { 0x10, KEY_ENTER },
+};
+
+static const char *const names[KEY_COUNT] = {
+    "?", "0", "1", "2", "3", "4", "5", "6", "7", "8", "9", "DELETE", "ENTER"
+};
+
+KeymapStats keymapStats;
+
+static unsigned long codes[KEYMAP_SLOTS];
+static unsigned char keys[KEYMAP_SLOTS];    // KEY_NONE: slot empty
+
+static unsigned char learning;              // key being learned
+static unsigned long learned[KEY_COUNT];    // codes taken this round
+
+//*****************************************************************************
+// Table
+//*****************************************************************************
+
+static unsigned long pack(unsigned int protocol, unsigned int address,
+                          unsigned int command) {
+    return (unsigned long)(protocol & 0xFF) << 24 | (unsigned long)(address & 0xFFFF) << 8 |
+           (command & 0xFF);
+}
+
+// The slot holding packed, or the empty slot where it would go
+static unsigned int find(unsigned long packed) {
+    unsigned int slot = ((unsigned int)packed * 2654435761U) >> (32 - KEYMAP_BITS);
+
+    keymapStats.searches++;
+    keymapStats.probes++;
+    while (keys[slot] != KEY_NONE && codes[slot] != packed) {
+        slot = (slot + 1) & (KEYMAP_SLOTS - 1);
+        keymapStats.probes++;
+    }
+    return slot;
+}
+
+static int bind(unsigned long packed, int key) {
+    unsigned int slot = find(packed);
+
+    if (keys[slot] == KEY_NONE) {
+        if (keymapStats.bindings == KEYMAP_LIMIT)
+            return 0;
+        keymapStats.bindings++;
+        codes[slot] = packed;
+    }
+    keys[slot] = key;
+    return 1;
+}
+
+static void clear(void) {
+    unsigned int i;
+
+    for (i = 0; i < KEYMAP_SLOTS; i++)
+        keys[i] = KEY_NONE;
+    keymapStats.bindings = 0;
+}
+
+static void bindLabRemote(void) {
+    unsigned int i;
+
+    clear();
+    for (i = 0; i < sizeof(labRemote) / sizeof(labRemote[0]); i++)
+        bind(pack(IR_NEC, LAB_ADDRESS, labRemote[i].command), labRemote[i].key);
+}
+
+//*****************************************************************************
+// Flash
+//*****************************************************************************
+
+#ifdef KEYMAP_FLASH
+static int load(void) {
+    KeymapHeader header;
+    KeymapRecord record;
+    unsigned long token = 0;
+    unsigned long offset;
+    long handle;
+    unsigned int i;
+    int ok = 1;
+
+    if (sl_FsOpen((unsigned char *)KEYMAP_FILE, FS_MODE_OPEN_READ, &token, &handle) < 0)
+        return 0;
+    if (sl_FsRead(handle, 0, (unsigned char *)&header, sizeof(header)) != sizeof(header) ||
+        header.magic != KEYMAP_MAGIC) {
+        sl_FsClose(handle, 0, 0, 0);
+        return 0;
+    }
+
+    clear();
+    offset = sizeof(header);
+    for (i = 0; i < header.count && keymapStats.bindings < KEYMAP_LIMIT; i++) {
+        if (sl_FsRead(handle, offset, (unsigned char *)&record, sizeof(record)) != sizeof(record)) {
+            ok = 0;
+            break;
+        }
+        offset += sizeof(record);
+        if (record.key != KEY_NONE && record.key < KEY_COUNT)
+            bind(record.code, record.key);
+    }
+    sl_FsClose(handle, 0, 0, 0);
+
+    // a short file is not trusted at all
+    if (!ok)
+        bindLabRemote();
+    return ok;
+}
+
+static int save(void) {
+    SlFsFileInfo_t info;
+    KeymapHeader header;
+    KeymapRecord record;
+    unsigned long token = 0;
+    unsigned long offset;
+    long handle;
+    unsigned int i;
+    int ok;
+
+    // a file made by a build with a smaller limit cannot take this one's
+    // table.  The file system rounds allocations up to whole blocks, so a
+    // file that is merely larger is kept.
+    if (sl_FsGetInfo((unsigned char *)KEYMAP_FILE, token, &info) == 0 &&
+        info.AllocatedLen < KEYMAP_FILE_SIZE)
+        sl_FsDel((unsigned char *)KEYMAP_FILE, token);
+
+    if (sl_FsOpen((unsigned char *)KEYMAP_FILE, FS_MODE_OPEN_WRITE, &token, &handle) < 0 &&
+        sl_FsOpen((unsigned char *)KEYMAP_FILE,
+                  FS_MODE_OPEN_CREATE(KEYMAP_FILE_SIZE, _FS_FILE_OPEN_FLAG_COMMIT | _FS_FILE_PUBLIC_WRITE),
+                  &token, &handle) < 0)
+        return 0;
+
+    header.magic = KEYMAP_MAGIC;
+    header.count = keymapStats.bindings;
+    ok = sl_FsWrite(handle, 0, (unsigned char *)&header, sizeof(header)) == sizeof(header);
+    offset = sizeof(header);
+    for (i = 0; i < KEYMAP_SLOTS && ok; i++) {
+        if (keys[i] != KEY_NONE) {
+            record.code = codes[i];
+            record.key = keys[i];
+            ok = sl_FsWrite(handle, offset, (unsigned char *)&record, sizeof(record)) == sizeof(record);
+            offset += sizeof(record);
+        }
+    }
+    sl_FsClose(handle, 0, 0, 0);
+    return ok;
+}
+#endif
+
+//*****************************************************************************
+// Interface
+//*****************************************************************************
+
+void keymapInit(void) {
+    bindLabRemote();
+#ifdef KEYMAP_FLASH
+    // a missing or unreadable file leaves the lab remote bound
+    load();
+#endif
+    learning = KEY_NONE;
+}
+
+int keymapLookup(const IRCode *code) {
+    return keys[find(pack(code->protocol, code->address, code->command))];
+}
+
+void keymapLearnStart(void) {
+    if (keymapStats.bindings + KEY_COUNT - 1 > KEYMAP_LIMIT)
+        bindLabRemote();
+    learning = KEY_0;
+}
+
+int keymapLearning(void) {
+    return learning != KEY_NONE;
+}
+
+int keymapLearn(const IRCode *code) {
+    unsigned long packed = pack(code->protocol, code->address, code->command);
+    int key;
+
+    if (learning == KEY_NONE)
+        return KEY_NONE;
+    for (key = KEY_0; key < learning; key++) {
+        if (learned[key] == packed)
+            return learning;
+    }
+
+    bind(packed, learning);
+    learned[learning] = packed;
+    if (++learning < KEY_COUNT)
+        return learning;
+
+    learning = KEY_NONE;
+#ifdef KEYMAP_FLASH
+    save();
+#endif
+    return KEY_NONE;
+}
+
+const char *keyName(int key) {
+    return key > KEY_NONE && key < KEY_COUNT ? names[key] : names[KEY_NONE];
+}
@@ -81,6 +81,7 @@ PinMuxConfig(void)
     PRCMPeripheralClkEnable(PRCM_GSPI, PRCM_RUN_MODE_CLK);
     PRCMPeripheralClkEnable(PRCM_UARTA0, PRCM_RUN_MODE_CLK);
     PRCMPeripheralClkEnable(PRCM_UARTA1, PRCM_RUN_MODE_CLK);
+    PRCMPeripheralClkEnable(PRCM_TIMERA3, PRCM_RUN_MODE_CLK);
 
     //
     // Configure PIN_64 for GPIOOutput
@@ -102,10 +103,9 @@ PinMuxConfig(void)
     GPIODirModeSet(GPIOA0_BASE, 0x8, GPIO_DIR_MODE_OUT);
 
     //
-    // Configure PIN_02 for GPIO Input
+    // Configure PIN_61 for TimerCP6 GT_CCP06
     //
-    PinTypeGPIO(PIN_61, PIN_MODE_0, false);
-    GPIODirModeSet(GPIOA0_BASE, 0x40, GPIO_DIR_MODE_IN);
+    PinTypeTimer(PIN_61, PIN_MODE_12);
 
     //
     // Configure PIN_18 for GPIO Output
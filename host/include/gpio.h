@@ -0,0 +1,13 @@
+//*****************************************************************************
+//
+// gpio.h - host build stub; implemented by ssd1351_emu.c
+//
+//*****************************************************************************
+
+#ifndef __GPIO_H__
+#define __GPIO_H__
+
+extern void GPIOPinWrite(unsigned long ulPort, unsigned char ucPins,
+                         unsigned char ucVal);
+
+#endif // __GPIO_H__
@@ -0,0 +1,10 @@
+//*****************************************************************************
+//
+// hw_common_reg.h - host build stub, nothing the display code needs lives here
+//
+//*****************************************************************************
+
+#ifndef __HW_COMMON_REG_H__
+#define __HW_COMMON_REG_H__
+
+#endif // __HW_COMMON_REG_H__
@@ -0,0 +1,10 @@
+//*****************************************************************************
+//
+// hw_ints.h - host build stub, nothing the display code needs lives here
+//
+//*****************************************************************************
+
+#ifndef __HW_INTS_H__
+#define __HW_INTS_H__
+
+#endif // __HW_INTS_H__
@@ -0,0 +1,21 @@
+//*****************************************************************************
+//
+// hw_memmap.h - host build stub with the peripheral base addresses the
+// display, input and IR capture code refers to
+//
+//*****************************************************************************
+
+#ifndef __HW_MEMMAP_H__
+#define __HW_MEMMAP_H__
+
+#define GPIOA0_BASE             0x40004000
+#define GPIOA1_BASE             0x40005000
+#define GPIOA2_BASE             0x40006000
+#define GPIOA3_BASE             0x40007000
+#define GSPI_BASE               0x44021000
+#define TIMERA0_BASE            0x40030000
+#define TIMERA1_BASE            0x40031000
+#define TIMERA2_BASE            0x40032000
+#define TIMERA3_BASE            0x40033000
+
+#endif // __HW_MEMMAP_H__
@@ -0,0 +1,13 @@
+//*****************************************************************************
+//
+// hw_types.h - host build stub; the driverlib sources get true and false
+// from here
+//
+//*****************************************************************************
+
+#ifndef __HW_TYPES_H__
+#define __HW_TYPES_H__
+
+#include <stdbool.h>
+
+#endif // __HW_TYPES_H__
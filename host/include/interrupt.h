@@ -0,0 +1,10 @@
+//*****************************************************************************
+//
+// interrupt.h - host build stub, nothing the display code needs lives here
+//
+//*****************************************************************************
+
+#ifndef __INTERRUPT_H__
+#define __INTERRUPT_H__
+
+#endif // __INTERRUPT_H__
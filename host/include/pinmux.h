@@ -0,0 +1,10 @@
+//*****************************************************************************
+//
+// pinmux.h - host build stub, nothing the display code needs lives here
+//
+//*****************************************************************************
+
+#ifndef __PINMUX_H__
+#define __PINMUX_H__
+
+#endif // __PINMUX_H__
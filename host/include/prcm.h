@@ -0,0 +1,10 @@
+//*****************************************************************************
+//
+// prcm.h - host build stub, nothing the display code needs lives here
+//
+//*****************************************************************************
+
+#ifndef __PRCM_H__
+#define __PRCM_H__
+
+#endif // __PRCM_H__
@@ -0,0 +1,10 @@
+//*****************************************************************************
+//
+// rom.h - host build stub, nothing the display code needs lives here
+//
+//*****************************************************************************
+
+#ifndef __ROM_H__
+#define __ROM_H__
+
+#endif // __ROM_H__
@@ -0,0 +1,22 @@
+//*****************************************************************************
+//
+// rom_map.h - host build stub; the MAP_ calls the IR capture code makes go
+// straight to the timer model in timer_emu.c
+//
+//*****************************************************************************
+
+#ifndef __ROM_MAP_H__
+#define __ROM_MAP_H__
+
+#define MAP_TimerConfigure      TimerConfigure
+#define MAP_TimerControlEvent   TimerControlEvent
+#define MAP_TimerPrescaleSet    TimerPrescaleSet
+#define MAP_TimerLoadSet        TimerLoadSet
+#define MAP_TimerIntRegister    TimerIntRegister
+#define MAP_TimerIntEnable      TimerIntEnable
+#define MAP_TimerIntStatus      TimerIntStatus
+#define MAP_TimerIntClear       TimerIntClear
+#define MAP_TimerValueGet       TimerValueGet
+#define MAP_TimerEnable         TimerEnable
+
+#endif // __ROM_MAP_H__
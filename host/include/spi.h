@@ -0,0 +1,17 @@
+//*****************************************************************************
+//
+// spi.h - host build stub; implemented by ssd1351_emu.c
+//
+//*****************************************************************************
+
+#ifndef __SPI_H__
+#define __SPI_H__
+
+extern void SPIDataPut(unsigned long ulBase, unsigned long ulData);
+extern void SPIDataGet(unsigned long ulBase, unsigned long *pulData);
+extern long SPIDataGetNonBlocking(unsigned long ulBase,
+                                  unsigned long *pulData);
+extern void SPICSEnable(unsigned long ulBase);
+extern void SPICSDisable(unsigned long ulBase);
+
+#endif // __SPI_H__
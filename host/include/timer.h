@@ -0,0 +1,39 @@
+//*****************************************************************************
+//
+// timer.h - host build stub; implemented by timer_emu.c
+//
+//*****************************************************************************
+
+#ifndef __TIMER_H__
+#define __TIMER_H__
+
+#define TIMER_CFG_SPLIT_PAIR    0x04000000
+#define TIMER_CFG_A_CAP_TIME    0x00000007
+
+#define TIMER_A                 0x000000FF
+#define TIMER_B                 0x0000FF00
+
+#define TIMER_EVENT_POS_EDGE    0x00000000
+#define TIMER_EVENT_NEG_EDGE    0x00000404
+#define TIMER_EVENT_BOTH_EDGES  0x00000C0C
+
+#define TIMER_TIMA_TIMEOUT      0x00000001
+#define TIMER_CAPA_MATCH        0x00000002
+#define TIMER_CAPA_EVENT        0x00000004
+
+extern void TimerConfigure(unsigned long ulBase, unsigned long ulConfig);
+extern void TimerControlEvent(unsigned long ulBase, unsigned long ulTimer,
+                              unsigned long ulEvent);
+extern void TimerPrescaleSet(unsigned long ulBase, unsigned long ulTimer,
+                             unsigned long ulValue);
+extern void TimerLoadSet(unsigned long ulBase, unsigned long ulTimer,
+                         unsigned long ulValue);
+extern void TimerIntRegister(unsigned long ulBase, unsigned long ulTimer,
+                             void (*pfnHandler)(void));
+extern void TimerIntEnable(unsigned long ulBase, unsigned long ulIntFlags);
+extern unsigned long TimerIntStatus(unsigned long ulBase, int bMasked);
+extern void TimerIntClear(unsigned long ulBase, unsigned long ulIntFlags);
+extern unsigned long TimerValueGet(unsigned long ulBase, unsigned long ulTimer);
+extern void TimerEnable(unsigned long ulBase, unsigned long ulTimer);
+
+#endif // __TIMER_H__
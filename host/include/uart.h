@@ -0,0 +1,10 @@
+//*****************************************************************************
+//
+// uart.h - host build stub, nothing the display code needs lives here
+//
+//*****************************************************************************
+
+#ifndef __UART_H__
+#define __UART_H__
+
+#endif // __UART_H__
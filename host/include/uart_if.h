@@ -0,0 +1,10 @@
+//*****************************************************************************
+//
+// uart_if.h - host build stub, nothing the display code needs lives here
+//
+//*****************************************************************************
+
+#ifndef __UART_IF_H__
+#define __UART_IF_H__
+
+#endif // __UART_IF_H__
@@ -0,0 +1,10 @@
+//*****************************************************************************
+//
+// utils.h - host build stub, nothing the display code needs lives here
+//
+//*****************************************************************************
+
+#ifndef __UTILS_H__
+#define __UTILS_H__
+
+#endif // __UTILS_H__
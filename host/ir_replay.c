@@ -0,0 +1,601 @@
+//*****************************************************************************
+//
+// ir_replay.c
+//
+// Replays IR receiver edges through the lab capture and decode code.  The
+// unmodified ircapture.c runs against the timer model in timer_emu.c, so
+// each edge goes through the capture interrupt, the pulse ring and
+// irdecode.c as it would on the board.
+//
+//   ir_replay [options] capture.csv    one edge per line: its time and,
+//                                      optionally, the line level after it
+//   ir_replay [options] capture.vcd    edges of the first 1-bit signal
+//   ir_replay [options] -g presses     generated key presses
+//
+// A capture prints every code decoded from it.  Generated presses pick a
+// protocol, address, command and hold time at random, and their edges can
+// be spoiled with jitter, receiver skew, glitches and dropped edges; every
+// frame sent is then checked off against what comes out, which gives the
+// decode accuracy and the false positives.  Both end with the edge
+// throughput and the time single edges took, capture interrupt and
+// decoding together: the worst one and the 99.9th percentile, since the
+// worst on a desktop OS is usually the process being preempted.
+//
+// Host timings only show relative cost; the target's numbers depend on
+// its compiler and flash wait states.
+//
+//*****************************************************************************
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hw_memmap.h"
+
+#include "ircapture.h"
+#include "irdecode.h"
+#include "timer_emu.h"
+
+#define IR_TIMER        TIMERA3_BASE
+#define START_US        10000.0     // first edge, after the timer starts
+#define MAX_CODES       8           // codes out of one edge
+
+typedef struct {
+    double start;           // us
+    IRCode code;            // what the decoder should make of it
+    int matched;
+} Frame;
+
+typedef struct {
+    IRCode code;
+    double start;           // us, of the pulse that completed it
+} Decoded;
+
+static double *edges;
+static unsigned long numEdges, edgeSpace;
+
+static Frame *frames;
+static unsigned long numFrames, frameSpace;
+
+// Generator settings
+static const char *protocolName = "mix";
+static unsigned long seed = 1;
+static double jitter, skew, glitchRate, dropRate;
+
+static double now;          // us
+static int inMark;
+static unsigned int rng;
+
+static unsigned long decoded, correct, falsePositives;
+static int verbose;
+
+static void *grow(void *p, unsigned long *space, size_t size) {
+    *space = *space ? 2 * *space : 1024;
+    p = realloc(p, *space * size);
+    if (!p) {
+        fprintf(stderr, "ir_replay: out of memory\n");
+        exit(2);
+    }
+    return p;
+}
+
+static void addEdge(double us) {
+    if (numEdges == edgeSpace)
+        edges = grow(edges, &edgeSpace, sizeof(*edges));
+    edges[numEdges++] = us;
+}
+
+static void addFrame(unsigned int protocol, unsigned int address,
+                     unsigned int command, int repeat) {
+    Frame *f;
+
+    if (numFrames == frameSpace)
+        frames = grow(frames, &frameSpace, sizeof(*frames));
+    f = &frames[numFrames++];
+    f->start = now;
+    f->code.protocol = protocol;
+    f->code.address = address;
+    f->code.command = command;
+    f->code.repeat = repeat;
+    f->matched = 0;
+}
+
+static int compareDoubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+//*****************************************************************************
+// Generated presses
+//*****************************************************************************
+
+static unsigned int random32(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static double uniform(double lo, double hi) {
+    return lo + (hi - lo) * (random32() / 4294967296.0);
+}
+
+static int chance(double rate) {
+    return rate > 0 && uniform(0, 1) < rate;
+}
+
+// The line goes to mark or space for us microseconds.  The receiver
+// stretches marks by the skew; every edge moves by up to the jitter, may
+// be lost, and may be followed by a glitch.
+static void level(int mark, double us) {
+    double t, w;
+
+    if (mark != inMark) {
+        t = now + (mark ? 0 : skew) + uniform(-jitter, jitter);
+        if (!chance(dropRate))
+            addEdge(t);
+        inMark = mark;
+    }
+    if (chance(glitchRate) && us > 10) {
+        w = uniform(5, 100 < us / 2 ? 100 : us / 2);
+        t = now + uniform(0, us - w);
+        addEdge(t);
+        addEdge(t + w);
+    }
+    now += us;
+}
+
+// Space to the end of a frame period that began at frameStart
+static void spaceUntil(double frameStart, double period) {
+    level(0, frameStart + period - now);
+}
+
+static void nec(unsigned int address, unsigned int command, int held) {
+    unsigned long data = address | (address ^ 0xFF) << 8 |
+                         (unsigned long)command << 16 | (unsigned long)(command ^ 0xFF) << 24;
+    double frameStart = now;
+    int b;
+
+    addFrame(IR_NEC, address, command, 0);
+    level(1, 9000);
+    level(0, 4500);
+    for (b = 0; b < 32; b++) {
+        level(1, 560);
+        level(0, (data >> b) & 1 ? 1690 : 560);
+    }
+    level(1, 560);
+    spaceUntil(frameStart, 108000);
+
+    while (held--) {
+        frameStart = now;
+        addFrame(IR_NEC, address, command, 1);
+        level(1, 9000);
+        level(0, 2250);
+        level(1, 560);
+        spaceUntil(frameStart, 108000);
+    }
+}
+
+static void rc5(unsigned int address, unsigned int command, int held) {
+    static int toggle;
+    unsigned long data = 1UL << 13 | (command & 0x40 ? 0 : 1UL << 12) |
+                         (unsigned long)toggle << 11 | address << 6 | (command & 0x3F);
+    double frameStart;
+    int frame, b, bit;
+
+    for (frame = 0; frame <= held; frame++) {
+        frameStart = now;
+        addFrame(IR_RC5, address, command, frame > 0);
+        for (b = 13; b >= 0; b--) {
+            bit = (data >> b) & 1;
+            level(!bit, 889);
+            level(bit, 889);
+        }
+        spaceUntil(frameStart, 113778);
+    }
+    toggle = !toggle;
+}
+
+static void sirc(int bits, unsigned int address, unsigned int command, int held) {
+    unsigned long data = command | (unsigned long)address << 7;
+    double frameStart;
+    int frame, b;
+
+    // a SIRC remote sends every frame at least three times
+    for (frame = 0; frame < 3 + held; frame++) {
+        frameStart = now;
+        addFrame(IR_SIRC, address, command, frame > 0);
+        level(1, 2400);
+        level(0, 600);
+        for (b = 0; b < bits; b++) {
+            level(1, (data >> b) & 1 ? 1200 : 600);
+            level(0, 600);
+        }
+        spaceUntil(frameStart, 45000);
+    }
+}
+
+static int generate(unsigned long presses) {
+    static const int sircBits[] = { 12, 15, 20 };
+    unsigned long i;
+    unsigned int protocol;
+    int bits;
+
+    if (!strcmp(protocolName, "nec"))
+        protocol = IR_NEC;
+    else if (!strcmp(protocolName, "rc5"))
+        protocol = IR_RC5;
+    else if (!strcmp(protocolName, "sirc"))
+        protocol = IR_SIRC;
+    else if (!strcmp(protocolName, "mix"))
+        protocol = IR_PROTOCOLS;
+    else
+        return 0;
+
+    rng = seed ? seed : 1;
+    now = START_US;
+    inMark = 0;
+    for (i = 0; i < presses; i++) {
+        switch (protocol == IR_PROTOCOLS ? random32() % IR_PROTOCOLS : protocol) {
+        case IR_NEC:
+            nec(random32() & 0xFF, random32() & 0xFF, random32() % 4);
+            break;
+        case IR_RC5:
+            rc5(random32() & 0x1F, random32() & 0x7F, random32() % 4);
+            break;
+        case IR_SIRC:
+            bits = sircBits[random32() % 3];
+            sirc(bits, random32() & ((1 << (bits - 7)) - 1), random32() & 0x7F,
+                 random32() % 3);
+            break;
+        }
+        // long enough for the capture to report the line idle
+        level(0, uniform(250000, 500000));
+    }
+    level(1, 560);
+
+    // jitter and glitches can leave edges out of order
+    qsort(edges, numEdges, sizeof(*edges), compareDoubles);
+    return 1;
+}
+
+//*****************************************************************************
+// Captures
+//*****************************************************************************
+
+// Microseconds per unit of a time such as "1us" or "10 ns"
+static double unitScale(const char *unit) {
+    char *end;
+    double n = strtod(unit, &end);
+
+    if (end == unit)
+        n = 1;
+    while (isspace((unsigned char)*end))
+        end++;
+    if (!strcmp(end, "s"))
+        return n * 1e6;
+    if (!strcmp(end, "ms"))
+        return n * 1e3;
+    if (!strcmp(end, "us"))
+        return n;
+    if (!strcmp(end, "ns"))
+        return n * 1e-3;
+    if (!strcmp(end, "ps"))
+        return n * 1e-6;
+    if (!strcmp(end, "fs"))
+        return n * 1e-9;
+    return 0;
+}
+
+// A time per line, with an optional level after it; lines that do not
+// start with a number (headers, comments) are skipped, and so are levels
+// that do not change
+static int readCsv(FILE *f, double scale) {
+    char line[256], *p, *end;
+    int level = 1, v;
+    double t;
+
+    while (fgets(line, sizeof(line), f)) {
+        t = strtod(line, &end);
+        if (end == line)
+            continue;
+        for (p = end; *p == ',' || *p == ';' || *p == ' ' || *p == '\t'; p++)
+            ;
+        if (isdigit((unsigned char)*p)) {
+            v = atoi(p) != 0;
+            if (v == level)
+                continue;
+            level = v;
+        }
+        addEdge(t * scale);
+    }
+    return 1;
+}
+
+// Value changes of the first 1-bit signal declared
+static int readVcd(FILE *f) {
+    char tok[256], id[256] = "", unit[64];
+    double scale = 1, t = 0;
+    int level = -1, v, size;
+
+    while (fscanf(f, "%255s", tok) == 1) {
+        if (!strcmp(tok, "$timescale")) {
+            unit[0] = '\0';
+            while (fscanf(f, "%255s", tok) == 1 && strcmp(tok, "$end"))
+                strncat(unit, tok, sizeof(unit) - strlen(unit) - 1);
+            scale = unitScale(unit);
+            if (!scale)
+                return 0;
+        } else if (!strcmp(tok, "$var")) {
+            // type, size, identifier, name ... $end
+            if (fscanf(f, "%*s %d %255s", &size, tok) != 2)
+                return 0;
+            if (!id[0] && size == 1)
+                snprintf(id, sizeof(id), "%s", tok);
+            while (fscanf(f, "%255s", tok) == 1 && strcmp(tok, "$end"))
+                ;
+        } else if (!strcmp(tok, "$date") || !strcmp(tok, "$version") ||
+                   !strcmp(tok, "$comment") || !strcmp(tok, "$scope") ||
+                   !strcmp(tok, "$upscope") || !strcmp(tok, "$enddefinitions")) {
+            while (fscanf(f, "%255s", tok) == 1 && strcmp(tok, "$end"))
+                ;
+        } else if (tok[0] == '#') {
+            t = atof(tok + 1) * scale;
+        } else if (strchr("bBrR", tok[0])) {
+            // vector or real value: its identifier follows
+            if (fscanf(f, "%*s") != 0)
+                break;
+        } else if ((tok[0] == '0' || tok[0] == '1') && id[0] && !strcmp(tok + 1, id)) {
+            v = tok[0] == '1';
+            if (level >= 0 && v != level)
+                addEdge(t);
+            level = v;
+        }
+    }
+    return id[0] != 0;
+}
+
+static int endsWith(const char *s, const char *suffix) {
+    size_t n = strlen(s), m = strlen(suffix);
+
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+static int readCapture(const char *path, double scale) {
+    FILE *f = fopen(path, "r");
+    unsigned long i;
+    double first;
+    int ok;
+
+    if (!f) {
+        perror(path);
+        return 0;
+    }
+    ok = endsWith(path, ".vcd") ? readVcd(f) : readCsv(f, scale);
+    fclose(f);
+    if (!ok) {
+        fprintf(stderr, "ir_replay: %s: cannot read it\n", path);
+        return 0;
+    }
+
+    // the first edge comes a little after the timer starts
+    first = numEdges ? edges[0] : 0;
+    for (i = 0; i < numEdges; i++)
+        edges[i] += START_US - first;
+    return 1;
+}
+
+// Edges as a capture file that ir_replay reads back: time in us, level
+static int writeCsv(const char *path) {
+    FILE *f = fopen(path, "w");
+    unsigned long i;
+
+    if (!f) {
+        perror(path);
+        return 0;
+    }
+    fprintf(f, "time_us,level\n");
+    for (i = 0; i < numEdges; i++)
+        fprintf(f, "%.3f,%lu\n", edges[i], i & 1);
+    return fclose(f) == 0;
+}
+
+//*****************************************************************************
+// Replay
+//*****************************************************************************
+
+static unsigned long long ticks(double us) {
+    return (unsigned long long)(us * (EMU_TIMER_HZ / 1000000.0) + 0.5);
+}
+
+static double nanoseconds(const struct timespec *a, const struct timespec *b) {
+    return (b->tv_sec - a->tv_sec) * 1e9 + (b->tv_nsec - a->tv_nsec);
+}
+
+static void printCode(const char *tag, const Decoded *d) {
+    printf("%s%10.3f ms  %-4s address %u command %u%s\n", tag, d->start / 1000,
+           irProtocolName(d->code.protocol), d->code.address, d->code.command,
+           d->code.repeat ? " repeat" : "");
+}
+
+// Check a decoded code off against the frame it came from
+static void score(const Decoded *d) {
+    static unsigned long cursor;
+    const Frame *f;
+
+    while (cursor + 1 < numFrames && frames[cursor + 1].start <= d->start)
+        cursor++;
+    f = &frames[cursor];
+    if (f->start <= d->start && !f->matched && f->code.protocol == d->code.protocol &&
+        f->code.address == d->code.address && f->code.command == d->code.command &&
+        f->code.repeat == d->code.repeat) {
+        frames[cursor].matched = 1;
+        correct++;
+        if (verbose)
+            printCode("  ", d);
+    } else {
+        falsePositives++;
+        if (verbose)
+            printCode("! ", d);
+    }
+}
+
+static void replay(double latencyUs) {
+    Decoded out[MAX_CODES];
+    struct timespec t0, t1;
+    unsigned long k, pulses = 0;
+    unsigned long pulse;
+    double *ns = malloc((numEdges + 1) * sizeof(*ns)), total = 0;
+    int n, i, p;
+    char key[32];
+
+    if (!ns) {
+        fprintf(stderr, "ir_replay: out of memory\n");
+        exit(2);
+    }
+
+    timerEmuReset();
+    timerEmuLatency(ticks(latencyUs));
+    irCaptureInit(IR_TIMER);
+    irDecodeInit();
+
+    for (k = 0; k < numEdges; k++) {
+        n = 0;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        timerEmuEdge(ticks(edges[k]));
+        while (irRead(&pulse)) {
+            pulses++;
+            if (irDecode(pulse, &out[n].code) && n < MAX_CODES)
+                n++;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+
+        ns[k] = nanoseconds(&t0, &t1);
+        total += ns[k];
+
+        // the pulses out of this edge began at the one before
+        for (i = 0; i < n; i++) {
+            out[i].start = k ? edges[k - 1] : edges[k];
+            decoded++;
+            if (numFrames)
+                score(&out[i]);
+            else
+                printCode("", &out[i]);
+        }
+    }
+
+    printf("edges        %lu\n", numEdges);
+    printf("pulses       %lu\n", pulses);
+    printf("overruns     %lu\n", irCaptureStats.overruns);
+    printf("max_depth    %lu\n", irCaptureStats.maxDepth);
+    printf("reloads      %lu\n", timerEmuStats.timeouts);
+    printf("shared_irqs  %lu\n", timerEmuStats.shared);
+    for (p = 0; p < IR_PROTOCOLS; p++) {
+        snprintf(key, sizeof(key), "%s_decoded", irProtocolName(p));
+        printf("%-12s %lu\n", key, irDecodeStats.decoded[p]);
+        snprintf(key, sizeof(key), "%s_rejected", irProtocolName(p));
+        printf("%-12s %lu\n", key, irDecodeStats.rejected[p]);
+    }
+    printf("decoded      %lu\n", decoded);
+    if (numFrames) {
+        printf("frames       %lu\n", numFrames);
+        printf("correct      %lu\n", correct);
+        printf("missed       %lu\n", numFrames - correct);
+        printf("false_pos    %lu\n", falsePositives);
+        printf("accuracy     %.2f\n", 100.0 * correct / numFrames);
+    }
+    if (numEdges && total > 0) {
+        printf("edges_per_s  %.0f\n", numEdges * 1e9 / total);
+        printf("mean_ns      %.1f\n", total / numEdges);
+        qsort(ns, numEdges, sizeof(*ns), compareDoubles);
+        printf("p999_ns      %.0f\n", ns[numEdges - 1 - numEdges / 1000]);
+        printf("worst_ns     %.0f\n", ns[numEdges - 1]);
+    }
+    free(ns);
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: ir_replay [options] capture.csv|capture.vcd\n"
+            "       ir_replay [options] -g presses\n"
+            "  -t unit    CSV time unit: s, ms, us (default) or ns\n"
+            "  -l us      interrupt latency, below the shortest pulse (default 2)\n"
+            "  -p proto   generated protocol: nec, rc5, sirc or mix (default)\n"
+            "  -s seed    generator seed (default 1)\n"
+            "  -j us      move every edge by up to this much either way\n"
+            "  -k us      stretch marks and shorten spaces by this much\n"
+            "  -G rate    glitches per pulse, 5 to 100 us wide\n"
+            "  -D rate    fraction of edges dropped\n"
+            "  -a pct     fail below this decode accuracy\n"
+            "  -f count   fail above this many false positives\n"
+            "  -o file    also write the generated edges as a CSV capture\n"
+            "  -v         list every code decoded from generated presses\n");
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL, *outPath = NULL;
+    unsigned long presses = 0;
+    double scale = 1, latency = 2, minAccuracy = 0;
+    long maxFalse = -1;
+    int a;
+
+    for (a = 1; a < argc; a++) {
+        if (!strcmp(argv[a], "-g") && a + 1 < argc) {
+            presses = strtoul(argv[++a], NULL, 0);
+        } else if (!strcmp(argv[a], "-t") && a + 1 < argc) {
+            scale = unitScale(argv[++a]);
+        } else if (!strcmp(argv[a], "-l") && a + 1 < argc) {
+            latency = atof(argv[++a]);
+        } else if (!strcmp(argv[a], "-p") && a + 1 < argc) {
+            protocolName = argv[++a];
+        } else if (!strcmp(argv[a], "-s") && a + 1 < argc) {
+            seed = strtoul(argv[++a], NULL, 0);
+        } else if (!strcmp(argv[a], "-j") && a + 1 < argc) {
+            jitter = atof(argv[++a]);
+        } else if (!strcmp(argv[a], "-k") && a + 1 < argc) {
+            skew = atof(argv[++a]);
+        } else if (!strcmp(argv[a], "-G") && a + 1 < argc) {
+            glitchRate = atof(argv[++a]);
+        } else if (!strcmp(argv[a], "-D") && a + 1 < argc) {
+            dropRate = atof(argv[++a]);
+        } else if (!strcmp(argv[a], "-a") && a + 1 < argc) {
+            minAccuracy = atof(argv[++a]);
+        } else if (!strcmp(argv[a], "-f") && a + 1 < argc) {
+            maxFalse = atol(argv[++a]);
+        } else if (!strcmp(argv[a], "-o") && a + 1 < argc) {
+            outPath = argv[++a];
+        } else if (!strcmp(argv[a], "-v")) {
+            verbose = 1;
+        } else if (argv[a][0] == '-' || path) {
+            usage();
+            return 2;
+        } else {
+            path = argv[a];
+        }
+    }
+
+    if (!presses == !path || !scale) {
+        usage();
+        return 2;
+    }
+    if (presses ? !generate(presses) : !readCapture(path, scale)) {
+        if (presses)
+            usage();
+        return 2;
+    }
+
+    if (presses && outPath && !writeCsv(outPath))
+        return 2;
+
+    replay(latency);
+
+    if (numFrames && (100.0 * correct / numFrames < minAccuracy ||
+                      (maxFalse >= 0 && falsePositives > (unsigned long)maxFalse))) {
+        fprintf(stderr, "ir_replay: %s below the limits\n", protocolName);
+        return 1;
+    }
+    return 0;
+}
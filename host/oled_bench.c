@@ -0,0 +1,29 @@
+//*****************************************************************************
+//
+// oled_bench.c
+//
+// Host run of the test.h graphics benchmark against the SSD1351 emulator.
+// Prints the same CSV the target prints over UART, minus the cycle counts.
+// Bit rates can be overridden with DEFS=-DBENCH_BIT_RATES=100000,400000.
+//
+//*****************************************************************************
+
+#include <stdio.h>
+
+#include "ssd1351_emu.h"
+
+#define GFX_BENCHMARK
+#define BENCH_HOST
+#define BENCH_PRINT         printf
+#define BENCH_EOL           "\n"
+
+#include "test.h"
+
+int main(void) {
+    emuReset();
+    Adafruit_Init();
+    emuClearStats();
+
+    benchmark();
+    return 0;
+}
@@ -0,0 +1,417 @@
+//*****************************************************************************
+//
+// oled_trace.c
+//
+// Runs a drawing scene through the graphics library against the SSD1351
+// emulator and reports what crossed the SPI bus.
+//
+//   oled_trace [-t trace.txt] [-o frame.ppm|frame.png] [-r rotation] [scene]
+//
+// Scenes: primitives (default), text, console, clear, fills, large, images,
+// redraw, sprites.  "-" as the trace file writes the transaction log to
+// stdout.  -r draws the scene
+// through setRotation(); the image is always the glass as mounted upright.
+//
+// "digest" is a 32-bit FNV-1a hash of the controller's GRAM, row by row.
+// Every build of the library without a palette has to leave the same GRAM
+// behind, so make check compares it against golden.txt.
+//
+// "covered" counts the non-black pixels on the glass, so for a scene drawn
+// once over the blank panel (fills) overdraw = pixels / covered should be 1.
+//
+// A display list build drains the queue one op at a time after the scene;
+// "list_step" is the most bytes any single op put on the bus, which bounds
+// how long one idle-loop drain can hold the CPU.  A framebuffer build
+// reports what the last displayFlush() sent ("frame_sent") against what
+// direct drawing would have cost ("frame_drawn"); for the redraw scene that
+// is the second frame.
+//
+//*****************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Adafruit_GFX.h"
+#include "Adafruit_SSD1351.h"
+#include "framebuffer.h"
+#include "stripbuffer.h"
+#include "glyphcache.h"
+#include "displaylist.h"
+#include "rgb565.h"
+#include "console.h"
+#include "sprite.h"
+#include "ssd1351_emu.h"
+
+#define RGB_BLACK   0x0000
+#define RGB_BLUE    0x001F
+#define RGB_RED     0xF800
+#define RGB_GREEN   0x07E0
+#define RGB_CYAN    0x07FF
+#define RGB_MAGENTA 0xF81F
+#define RGB_YELLOW  0xFFE0
+#define RGB_WHITE   0xFFFF
+
+// Colours for the drawing calls.  An indexed build takes palette indices,
+// and the default palette holds all eight; images stay RGB565.
+#if defined(SSD1351_INDEXED)
+#define BLACK       PAL_BLACK
+#define BLUE        PAL_BLUE
+#define RED         PAL_RED
+#define GREEN       PAL_GREEN
+#define CYAN        PAL_CYAN
+#define MAGENTA     PAL_MAGENTA
+#define YELLOW      PAL_YELLOW
+#define WHITE       PAL_WHITE
+#else
+#define BLACK       RGB_BLACK
+#define BLUE        RGB_BLUE
+#define RED         RGB_RED
+#define GREEN       RGB_GREEN
+#define CYAN        RGB_CYAN
+#define MAGENTA     RGB_MAGENTA
+#define YELLOW      RGB_YELLOW
+#define WHITE       RGB_WHITE
+#endif
+
+static void scenePrimitives(void) {
+    fillScreen(BLACK);
+    fillCircle(40, 40, 20, GREEN);
+    drawCircle(90, 40, 25, RED);
+    fillTriangle(10, 120, 60, 70, 100, 125, BLUE);
+    drawLine(0, 0, 127, 100, WHITE);
+    drawLine(5, 127, 120, 3, YELLOW);
+    fillRoundRect(70, 80, 50, 40, 8, MAGENTA);
+    drawRoundRect(2, 60, 60, 30, 6, CYAN);
+    drawRect(0, 0, 20, 20, WHITE);
+    setCursor(3, 3);
+    setTextColor(WHITE, BLACK);
+    Outstr("Hello 123");
+}
+
+static void sceneText(void) {
+    fillScreen(BLACK);
+    setCursor(0, 0);
+    setTextColor(GREEN, BLACK);
+    Outstr("The quick brown fox jumps over the lazy dog. 0123456789 "
+           "!\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~");
+    setCursor(0, 64);
+    setTextColor(YELLOW, YELLOW);
+    Outstr("Transparent text over the background");
+}
+
+static void sceneConsole(void) {
+    int i, x;
+
+    consoleInit(WHITE, BLACK);
+    for (i = 0; i < 20; i++) {
+        consolePrint(i & 1 ? "received message that is long enough to wrap" : "hello", GREEN);
+        for (x = 0; x < 5 * 6; x += 6)
+            consoleInputPut(x, 'A' + i);
+        if (i % 3 == 0)
+            consoleNewline();
+    }
+}
+
+// Filled shapes that neither overlap nor clear the screen first, some of
+// them clipped by the edges
+static void sceneFills(void) {
+    static const int arrowX[] = { 58, 74, 74, 86, 74, 74, 58 };
+    static const int arrowY[] = { 100, 100, 92, 106, 120, 112, 112 };
+
+    fillCircle(20, 20, 18, GREEN);
+    fillCircle(50, 10, 8, RED);
+    fillCircle(0, 64, 12, CYAN);
+    fillEllipse(95, 20, 30, 12, YELLOW);
+    fillEllipse(64, 60, 12, 22, MAGENTA);
+    fillRoundRect(16, 44, 28, 40, 8, BLUE);
+    fillRoundRect(84, 44, 40, 30, 14, WHITE);
+    fillRoundRect(90, 100, 50, 40, 10, GREEN);
+    fillEllipse(30, 110, 24, 10, RED);
+    fillPolygon(arrowX, arrowY, 7, CYAN);
+    fillTriangle(120, 78, 100, 90, 80, 80, YELLOW);
+}
+
+// Shapes far larger than the screen, only partly on it
+static void sceneLarge(void) {
+    fillScreen(BLACK);
+    fillRoundRect(-10, -10, 1000, 1000, 300, BLUE);
+    fillRoundRect(0, 0, 300, 300, 140, RED);
+    fillRoundRect(64, 64, 300, 300, 140, GREEN);
+    fillCircle(200, -60, 150, YELLOW);
+}
+
+// 16x16 envelope, 1 bit per pixel, MSB first
+static const unsigned char envelope[] = {
+    0xFF, 0xFF, 0xC0, 0x03, 0xA0, 0x05, 0x90, 0x09,
+    0x88, 0x11, 0x84, 0x21, 0x82, 0x41, 0x81, 0x81,
+    0x80, 0x01, 0x80, 0x01, 0x80, 0x01, 0x80, 0x01,
+    0x80, 0x01, 0x80, 0x01, 0x80, 0x01, 0xFF, 0xFF,
+};
+
+// 12x4 run-length encoded bars, with runs crossing the row ends
+static const unsigned short bars[] = {
+    18, RGB_RED, RLE_LITERAL | 6, RGB_BLUE, RGB_GREEN, RGB_BLUE, RGB_GREEN, RGB_BLUE, RGB_GREEN,
+    24, RGB_YELLOW,
+};
+
+static unsigned short gradient[32 * 32];
+
+// Every blitter, whole and clipped by the screen edges
+static void sceneImages(void) {
+    int x, y;
+
+    for (y = 0; y < 32; y++)
+        for (x = 0; x < 32; x++)
+            gradient[y * 32 + x] = x << 11 | (y * 2) << 5 | 16;
+
+    fillScreen(BLACK);
+    drawRGBBitmap(8, 8, gradient, 32, 32);
+    drawRGBBitmap(110, 100, gradient, 32, 32);
+    drawRGBBitmap(-16, 60, gradient, 32, 32);
+    drawBitmap(50, 8, envelope, 16, 16, WHITE);
+    drawXBitmap(50, 30, envelope, 16, 16, MAGENTA);
+    drawBitmapBg(72, 8, envelope, 16, 16, BLACK, CYAN);
+    drawBitmapBg(120, -6, envelope, 16, 16, WHITE, RED);
+    drawRLEBitmap(40, 60, bars, 12, 4);
+    drawRLEBitmap(60, 70, bars, 6, 8);
+    drawRLEBitmap(122, 80, bars, 12, 4);
+}
+
+static void sceneClear(void) {
+    fillScreen(BLUE);
+}
+
+// A texting screen redrawn from scratch every frame, the way a simple UI
+// loop would; the second frame differs by one typed character
+static void drawTextingFrame(char *input) {
+    fillScreen(BLACK);
+    fillRect(0, 0, 128, 11, BLUE);
+    setCursor(2, 2);
+    setTextColor(WHITE, BLUE);
+    Outstr("Messages");
+    setTextColor(GREEN, BLACK);
+    setCursor(0, 16);
+    Outstr("hello");
+    setCursor(0, 26);
+    Outstr("are you there?");
+    drawFastHLine(0, 115, 128, WHITE);
+    setCursor(0, 119);
+    setTextColor(WHITE, BLACK);
+    Outstr(input);
+}
+
+static void sceneRedraw(void) {
+    drawTextingFrame("on my wa");
+#if defined(SSD1351_FRAMEBUFFER)
+    displayFlush();
+#endif
+    drawTextingFrame("on my way");
+}
+
+// The Lab2 tilt ball as a sprite, plus a square that passes over it and
+// a jump far enough that the two boxes are redrawn apart
+static void sceneSprites(void) {
+    static const unsigned short ballImage[25] = {
+        RGB_BLACK, RGB_CYAN, RGB_CYAN, RGB_CYAN, RGB_BLACK,
+        RGB_CYAN,  RGB_CYAN, RGB_CYAN, RGB_CYAN, RGB_CYAN,
+        RGB_CYAN,  RGB_CYAN, RGB_CYAN, RGB_CYAN, RGB_CYAN,
+        RGB_CYAN,  RGB_CYAN, RGB_CYAN, RGB_CYAN, RGB_CYAN,
+        RGB_BLACK, RGB_CYAN, RGB_CYAN, RGB_CYAN, RGB_BLACK,
+    };
+    static unsigned short squareImage[8 * 8];
+    static Sprite ball = { .w = 5, .h = 5, .image = ballImage, .key = RGB_BLACK, .visible = 1 };
+    static Sprite square = { .w = 8, .h = 8, .image = squareImage, .key = SPRITE_NO_KEY, .visible = 1 };
+    int i;
+
+    fill16(squareImage, RGB_MAGENTA, 8 * 8);
+    fillScreen(BLACK);
+    spriteBackground(BLACK, 0);
+    ball.x = 62;
+    ball.y = 62;
+    square.x = 40;
+    square.y = 70;
+    spriteAdd(&square);
+    spriteAdd(&ball);
+    spriteFrame();
+
+    for (i = 0; i < 30; i++) {
+        ball.x += 1;
+        ball.y += i & 1;
+        square.x += 2;
+        spriteFrame();
+    }
+    ball.x = 10;
+    ball.y = 10;
+    spriteFrame();
+    square.visible = 0;
+    spriteFrame();
+    spriteRemove(&square);
+}
+
+static const struct {
+    const char *name;
+    void (*draw)(void);
+} scenes[] = {
+    { "primitives", scenePrimitives },
+    { "text", sceneText },
+    { "console", sceneConsole },
+    { "clear", sceneClear },
+    { "fills", sceneFills },
+    { "large", sceneLarge },
+    { "images", sceneImages },
+    { "redraw", sceneRedraw },
+    { "sprites", sceneSprites },
+};
+
+#define NUM_SCENES (sizeof(scenes) / sizeof(scenes[0]))
+
+static void usage(void) {
+    unsigned int i;
+
+    fprintf(stderr, "usage: oled_trace [-t trace.txt] [-o frame.ppm|frame.png] [-r rotation] [scene]\n");
+    fprintf(stderr, "scenes:");
+    for (i = 0; i < NUM_SCENES; i++)
+        fprintf(stderr, " %s", scenes[i].name);
+    fprintf(stderr, "\n");
+}
+
+static int endsWith(const char *s, const char *suffix) {
+    size_t n = strlen(s), m = strlen(suffix);
+
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+static unsigned int gramDigest(void) {
+    unsigned int h = 2166136261U;
+    int c, r;
+
+    for (r = 0; r < EMU_HEIGHT; r++)
+        for (c = 0; c < EMU_WIDTH; c++)
+            h = (h ^ emuGram(c, r)) * 16777619U;
+    return h;
+}
+
+int main(int argc, char **argv) {
+    const char *tracePath = NULL;
+    const char *outPath = NULL;
+    const char *name = scenes[0].name;
+    FILE *traceFile = NULL;
+    unsigned long covered = 0;
+    unsigned char rotation = 0;
+    unsigned int i;
+    int a, op, x, y;
+#if defined(SSD1351_DISPLAYLIST)
+    unsigned long listStep = 0;
+    int listQueued, listLeft;
+#endif
+
+    for (a = 1; a < argc; a++) {
+        if (!strcmp(argv[a], "-t") && a + 1 < argc) {
+            tracePath = argv[++a];
+        } else if (!strcmp(argv[a], "-o") && a + 1 < argc) {
+            outPath = argv[++a];
+        } else if (!strcmp(argv[a], "-r") && a + 1 < argc) {
+            rotation = atoi(argv[++a]);
+        } else if (argv[a][0] == '-') {
+            usage();
+            return 2;
+        } else {
+            name = argv[a];
+        }
+    }
+
+    for (i = 0; i < NUM_SCENES; i++)
+        if (!strcmp(scenes[i].name, name))
+            break;
+    if (i == NUM_SCENES) {
+        usage();
+        return 2;
+    }
+
+    emuReset();
+    Adafruit_Init();
+    setRotation(rotation);
+#if defined(SSD1351_DISPLAYLIST)
+    displayFence();
+#endif
+    emuClearStats();
+
+    if (tracePath) {
+        traceFile = strcmp(tracePath, "-") ? fopen(tracePath, "w") : stdout;
+        if (!traceFile) {
+            perror(tracePath);
+            return 1;
+        }
+        emuTrace(traceFile);
+    }
+
+#if defined(SSD1351_STRIPBUFFER)
+    stripBegin(BLACK);
+    scenes[i].draw();
+    stripEnd();
+#else
+    scenes[i].draw();
+#endif
+#if defined(SSD1351_FRAMEBUFFER)
+    displayFlush();
+#endif
+#if defined(SSD1351_DISPLAYLIST)
+    listQueued = displayDrain(0);
+    do {
+        unsigned long before = oledStats.bytes;
+
+        listLeft = displayDrain(1);
+        if (oledStats.bytes - before > listStep)
+            listStep = oledStats.bytes - before;
+    } while (listLeft);
+#endif
+
+    emuTrace(NULL);
+    if (traceFile && traceFile != stdout)
+        fclose(traceFile);
+
+    for (y = 0; y < SSD1351HEIGHT; y++)
+        for (x = 0; x < SSD1351WIDTH; x++)
+            if (emuPixel(x, y))
+                covered++;
+
+    printf("scene        %s\n", scenes[i].name);
+    printf("commands     %lu\n", emuStats.commands);
+    printf("data_bytes   %lu\n", emuStats.dataBytes);
+    printf("cs_toggles   %lu\n", emuStats.csToggles);
+    printf("dc_toggles   %lu\n", emuStats.dcToggles);
+    printf("pixels       %lu\n", emuStats.pixels);
+    printf("digest       %08x\n", gramDigest());
+    printf("covered      %lu\n", covered);
+    if (covered)
+        printf("overdraw     %.3f\n", (double)emuStats.pixels / covered);
+    for (op = 0; op < 256; op++)
+        if (emuStats.opcodes[op])
+            printf("opcode_%02X    %lu\n", op, emuStats.opcodes[op]);
+#if defined(SSD1351_FRAMEBUFFER)
+    printf("frame_drawn  %lu\n", frameStats.drawnBytes);
+    printf("frame_sent   %lu\n", frameStats.sentBytes);
+#endif
+#if defined(SSD1351_GLYPHCACHE)
+    printf("glyph_hits   %lu\n", glyphCacheStats.hits);
+    printf("glyph_misses %lu\n", glyphCacheStats.misses);
+    printf("glyph_bytes  %lu\n", glyphCacheStats.bytes);
+#endif
+#if defined(SSD1351_DISPLAYLIST)
+    printf("list_ops     %lu\n", displayListStats.recorded);
+    printf("list_queued  %d\n", listQueued);
+    printf("list_stalls  %lu\n", displayListStats.stalls);
+    printf("list_step    %lu\n", listStep);
+#endif
+
+    if (outPath) {
+        int err = endsWith(outPath, ".png") ? emuWritePNG(outPath) : emuWritePPM(outPath);
+
+        if (err) {
+            perror(outPath);
+            return 1;
+        }
+    }
+    return 0;
+}
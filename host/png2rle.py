@@ -0,0 +1,285 @@
+#!/usr/bin/env python3
+#
+# png2rle.py
+#
+# Converts a PNG image into a C array for the graphics library's image
+# blitters:
+#
+#   rle     drawRLEBitmap() runs (default)
+#   rgb565  drawRGBBitmap() pixels
+#   mono    drawBitmap()/drawBitmapBg() bits, MSB first, set where the
+#           pixel is brighter than --threshold
+#
+#   png2rle.py [-f rle|rgb565|mono] [-n name] [-b RRGGBB] [-o out.h] image.png
+#
+# Only the standard library is used; the PNG is inflated with zlib.  Any
+# colour type and bit depth is accepted, but not interlaced images.  Alpha
+# is blended over the -b colour (black by default).
+#
+
+import argparse
+import os
+import re
+import struct
+import sys
+import zlib
+
+RLE_LITERAL = 0x8000
+RLE_MAX = 0x7FFF
+
+PNG_SIGNATURE = b'\x89PNG\r\n\x1a\n'
+
+# samples per pixel for each PNG colour type
+CHANNELS = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}
+
+
+class PngError(Exception):
+    pass
+
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+
+def unfilter(data, width, height, bits_per_pixel):
+    stride = (width * bits_per_pixel + 7) // 8
+    bpp = max(1, bits_per_pixel // 8)
+    rows = []
+    prev = bytearray(stride)
+    pos = 0
+    for _ in range(height):
+        if pos + 1 + stride > len(data):
+            raise PngError('image data is truncated')
+        ftype = data[pos]
+        row = bytearray(data[pos + 1:pos + 1 + stride])
+        pos += 1 + stride
+        for i in range(stride):
+            a = row[i - bpp] if i >= bpp else 0
+            b = prev[i]
+            c = prev[i - bpp] if i >= bpp else 0
+            if ftype == 1:
+                row[i] = (row[i] + a) & 0xFF
+            elif ftype == 2:
+                row[i] = (row[i] + b) & 0xFF
+            elif ftype == 3:
+                row[i] = (row[i] + ((a + b) >> 1)) & 0xFF
+            elif ftype == 4:
+                row[i] = (row[i] + paeth(a, b, c)) & 0xFF
+            elif ftype != 0:
+                raise PngError('bad filter type %d' % ftype)
+        rows.append(row)
+        prev = row
+    return rows
+
+
+def samples(row, count, depth):
+    """Unpack count samples of the given bit depth from a scanline."""
+    if depth == 8:
+        return list(row[:count])
+    if depth == 16:
+        return [row[2 * i] << 8 | row[2 * i + 1] for i in range(count)]
+    per_byte = 8 // depth
+    mask = (1 << depth) - 1
+    return [(row[i // per_byte] >> (8 - depth * (i % per_byte + 1))) & mask
+            for i in range(count)]
+
+
+def read_png(path):
+    """Return (width, height, pixels) with pixels as rows of (r, g, b, a)."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if not data.startswith(PNG_SIGNATURE):
+        raise PngError('not a PNG file')
+
+    pos = len(PNG_SIGNATURE)
+    idat = []
+    palette = []
+    trns = None
+    header = None
+    while pos + 8 <= len(data):
+        length, kind = struct.unpack('>I4s', data[pos:pos + 8])
+        body = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if kind == b'IHDR':
+            header = struct.unpack('>IIBBBBB', body)
+        elif kind == b'PLTE':
+            palette = [tuple(body[i:i + 3]) for i in range(0, len(body), 3)]
+        elif kind == b'tRNS':
+            trns = body
+        elif kind == b'IDAT':
+            idat.append(body)
+        elif kind == b'IEND':
+            break
+    if header is None:
+        raise PngError('missing IHDR')
+
+    width, height, depth, ctype, _, _, interlace = header
+    if ctype not in CHANNELS:
+        raise PngError('bad colour type %d' % ctype)
+    if interlace:
+        raise PngError('interlaced images are not supported')
+
+    channels = CHANNELS[ctype]
+    rows = unfilter(zlib.decompress(b''.join(idat)), width, height,
+                    channels * depth)
+    top = (1 << depth) - 1
+
+    def scale(v):
+        return v * 255 // top
+
+    pixels = []
+    for row in rows:
+        s = samples(row, width * channels, depth)
+        out = []
+        for i in range(width):
+            px = s[i * channels:(i + 1) * channels]
+            if ctype == 3:
+                if px[0] >= len(palette):
+                    raise PngError('palette index out of range')
+                r, g, b = palette[px[0]]
+                a = trns[px[0]] if trns and px[0] < len(trns) else 255
+            elif ctype in (0, 4):
+                r = g = b = scale(px[0])
+                a = scale(px[1]) if ctype == 4 else 255
+                if ctype == 0 and trns and len(trns) >= 2 and \
+                        px[0] == struct.unpack('>H', trns[:2])[0]:
+                    a = 0
+            else:
+                r, g, b = (scale(v) for v in px[:3])
+                a = scale(px[3]) if ctype == 6 else 255
+                if ctype == 2 and trns and len(trns) >= 6 and \
+                        tuple(px[:3]) == struct.unpack('>HHH', trns[:6]):
+                    a = 0
+            out.append((r, g, b, a))
+        pixels.append(out)
+    return width, height, pixels
+
+
+def color565(r, g, b):
+    # same packing as Color565() in Adafruit_OLED.c
+    return (r >> 3) << 11 | (g >> 2) << 5 | b >> 3
+
+
+def flatten(pixels, bg):
+    out = []
+    for row in pixels:
+        for r, g, b, a in row:
+            r = (r * a + bg[0] * (255 - a)) // 255
+            g = (g * a + bg[1] * (255 - a)) // 255
+            b = (b * a + bg[2] * (255 - a)) // 255
+            out.append((r, g, b))
+    return out
+
+
+def encode_rle(colors):
+    """Runs of three or more equal pixels repeat, the rest go as literals."""
+    words = []
+    literal = []
+
+    def flush():
+        while literal:
+            n = min(len(literal), RLE_MAX)
+            words.append(RLE_LITERAL | n)
+            words.extend(literal[:n])
+            del literal[:n]
+
+    i = 0
+    while i < len(colors):
+        n = 1
+        while i + n < len(colors) and n < RLE_MAX and colors[i + n] == colors[i]:
+            n += 1
+        if n >= 3:
+            flush()
+            words.extend((n, colors[i]))
+        else:
+            literal.extend(colors[i:i + n])
+        i += n
+    flush()
+    return words
+
+
+def encode_mono(rgb, width, threshold):
+    data = []
+    for y in range(len(rgb) // width):
+        row = rgb[y * width:(y + 1) * width]
+        for x in range(0, width, 8):
+            byte = 0
+            for k, (r, g, b) in enumerate(row[x:x + 8]):
+                if (r * 299 + g * 587 + b * 114) // 1000 > threshold:
+                    byte |= 0x80 >> k
+            data.append(byte)
+    return data
+
+
+def c_array(ctype, name, values, digits, per_line):
+    lines = ['const %s %s[] = {' % (ctype, name)]
+    for i in range(0, len(values), per_line):
+        chunk = values[i:i + per_line]
+        lines.append('    ' + ', '.join('0x%0*X' % (digits, v) for v in chunk) + ',')
+    lines.append('};')
+    return '\n'.join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert a PNG image into a C array '
+                                     'for the OLED image blitters.')
+    parser.add_argument('image')
+    parser.add_argument('-f', '--format', choices=('rle', 'rgb565', 'mono'), default='rle')
+    parser.add_argument('-n', '--name', help='array name (default: from the file name)')
+    parser.add_argument('-b', '--background', default='000000',
+                        help='RRGGBB colour that alpha is blended over')
+    parser.add_argument('-t', '--threshold', type=int, default=127,
+                        help='mono: brightness above which a bit is set')
+    parser.add_argument('-o', '--output', help='output file (default: stdout)')
+    args = parser.parse_args()
+
+    name = args.name or re.sub(r'\W', '_', os.path.splitext(os.path.basename(args.image))[0])
+    if not re.match(r'[A-Za-z_]', name):
+        name = '_' + name
+    if not re.match(r'^[0-9A-Fa-f]{6}$', args.background):
+        parser.error('background must be RRGGBB')
+    bg = tuple(int(args.background[i:i + 2], 16) for i in (0, 2, 4))
+
+    try:
+        width, height, pixels = read_png(args.image)
+    except (OSError, PngError, zlib.error) as e:
+        sys.exit('png2rle: %s: %s' % (args.image, e))
+
+    rgb = flatten(pixels, bg)
+    colors = [color565(*p) for p in rgb]
+    if args.format == 'rle':
+        words = encode_rle(colors)
+        body = c_array('unsigned short', name, words, 4, 12)
+        what = '%d words, %d%% of raw' % (len(words), 100 * len(words) // max(1, len(colors)))
+        draw = 'drawRLEBitmap'
+    elif args.format == 'rgb565':
+        body = c_array('unsigned short', name, colors, 4, 12)
+        what = '%d words' % len(colors)
+        draw = 'drawRGBBitmap'
+    else:
+        data = encode_mono(rgb, width, args.threshold)
+        body = c_array('unsigned char', name, data, 2, 16)
+        what = '%d bytes' % len(data)
+        draw = 'drawBitmap'
+
+    upper = name.upper()
+    text = ('// %s: %dx%d, %s, for %s()\n'
+            '// generated by png2rle.py -f %s\n\n'
+            '#define %s_WIDTH %d\n'
+            '#define %s_HEIGHT %d\n\n'
+            '%s\n') % (os.path.basename(args.image), width, height, what, draw,
+                       args.format, upper, width, upper, height, body)
+
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write(text)
+    else:
+        sys.stdout.write(text)
+
+
+if __name__ == '__main__':
+    main()
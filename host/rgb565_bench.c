@@ -0,0 +1,214 @@
+//*****************************************************************************
+//
+// rgb565_bench.c
+//
+// Host timing of the rgb565.c kernels against the plain per-pixel loops
+// they replace, with Color565() from Adafruit_OLED.c as the scalar
+// converter.  Every kernel is first checked against its scalar version on
+// random data, odd alignments and odd lengths included; a mismatch fails
+// the run.  Prints CSV: nanoseconds per pixel for each.
+//
+// Host timings only show the relative cost of the two versions; the
+// target's numbers depend on its compiler and flash wait states.
+//
+//*****************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "rgb565.h"
+
+#define PIXELS      (128 * 128)
+#define MIN_SECONDS 0.2
+
+unsigned int Color565(unsigned char r, unsigned char g, unsigned char b);
+
+static unsigned short bufA[PIXELS + 2], bufB[PIXELS + 2], bufC[PIXELS + 2];
+static unsigned char rgb[3 * (PIXELS + 2)];
+static volatile unsigned int sink;
+
+//*****************************************************************************
+// Scalar versions
+//*****************************************************************************
+
+static void scalarFill(unsigned short *dst, unsigned int color, unsigned long n) {
+    while (n--)
+        *dst++ = color;
+}
+
+static void scalarCopy(unsigned short *dst, const unsigned short *src, unsigned long n) {
+    while (n--)
+        *dst++ = *src++;
+}
+
+static unsigned int channel(unsigned int p, int shift, unsigned int mask) {
+    return (p >> shift) & mask;
+}
+
+static void scalarBlend50(unsigned short *dst, const unsigned short *src, unsigned long n) {
+    while (n--) {
+        unsigned int a = *dst, b = *src++;
+
+        *dst++ = ((channel(a, 11, 31) + channel(b, 11, 31)) >> 1) << 11 |
+                 ((channel(a, 5, 63) + channel(b, 5, 63)) >> 1) << 5 |
+                 (channel(a, 0, 31) + channel(b, 0, 31)) >> 1;
+    }
+}
+
+static int mixChannel(int bg, int fg, int a) {
+    return bg + (((fg - bg) * a) >> 5);
+}
+
+static void scalarBlendAlpha(unsigned short *dst, const unsigned short *src,
+                             unsigned int alpha, unsigned long n) {
+    int a = (alpha + 4) >> 3;
+
+    while (n--) {
+        unsigned int d = *dst, s = *src++;
+
+        *dst++ = mixChannel(channel(d, 11, 31), channel(s, 11, 31), a) << 11 |
+                 mixChannel(channel(d, 5, 63), channel(s, 5, 63), a) << 5 |
+                 mixChannel(channel(d, 0, 31), channel(s, 0, 31), a);
+    }
+}
+
+static void scalarConvert(unsigned short *dst, const unsigned char *p, unsigned long n) {
+    while (n--) {
+        *dst++ = Color565(p[0], p[1], p[2]);
+        p += 3;
+    }
+}
+
+//*****************************************************************************
+// Checks
+//*****************************************************************************
+
+static void randomize(void) {
+    unsigned long i;
+
+    for (i = 0; i < PIXELS + 2; i++) {
+        bufA[i] = rand();
+        bufB[i] = rand();
+    }
+    for (i = 0; i < sizeof(rgb); i++)
+        rgb[i] = rand();
+}
+
+static int same(const char *what, int off, unsigned long n, unsigned int alpha) {
+    if (memcmp(bufA, bufC, sizeof(bufA)) == 0)
+        return 1;
+    fprintf(stderr, "rgb565_bench: %s differs (offset %d, %lu pixels, alpha %u)\n",
+            what, off, n, alpha);
+    return 0;
+}
+
+static int check(void) {
+    static const unsigned long lengths[] = { 0, 1, 2, 3, 7, 8, 9, 31, 1000 };
+    unsigned int alpha;
+    unsigned int i;
+    int off, soff, ok = 1;
+
+    for (off = 0; off < 2; off++) {
+        for (soff = 0; soff < 2; soff++) {
+            for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+                unsigned long n = lengths[i];
+
+                randomize();
+                memcpy(bufC, bufA, sizeof(bufA));
+                fill16(bufA + off, 0x1234, n);
+                scalarFill(bufC + off, 0x1234, n);
+                ok &= same("fill16", off, n, 0);
+
+                memcpy(bufC, bufA, sizeof(bufA));
+                copy16(bufA + off, bufB + soff, n);
+                scalarCopy(bufC + off, bufB + soff, n);
+                ok &= same("copy16", off, n, 0);
+
+                memcpy(bufC, bufA, sizeof(bufA));
+                blend50(bufA + off, bufB + soff, n);
+                scalarBlend50(bufC + off, bufB + soff, n);
+                ok &= same("blend50", off, n, 0);
+
+                for (alpha = 0; alpha < 256; alpha += 5) {
+                    memcpy(bufC, bufA, sizeof(bufA));
+                    blendAlpha(bufA + off, bufB + soff, alpha, n);
+                    scalarBlendAlpha(bufC + off, bufB + soff, alpha, n);
+                    ok &= same("blendAlpha", off, n, alpha);
+                }
+
+                memcpy(bufC, bufA, sizeof(bufA));
+                color565Buffer(bufA + off, rgb + 3 * soff, n);
+                scalarConvert(bufC + off, rgb + 3 * soff, n);
+                ok &= same("color565Buffer", off, n, 0);
+            }
+        }
+    }
+    return ok;
+}
+
+//*****************************************************************************
+// Timing
+//*****************************************************************************
+
+enum { FILL, COPY, BLEND50, BLEND_ALPHA, CONVERT };
+
+static void run(int kernel, int swar) {
+    switch (kernel) {
+    case FILL:
+        if (swar) fill16(bufA, 0x7BEF, PIXELS);
+        else scalarFill(bufA, 0x7BEF, PIXELS);
+        break;
+    case COPY:
+        if (swar) copy16(bufA, bufB, PIXELS);
+        else scalarCopy(bufA, bufB, PIXELS);
+        break;
+    case BLEND50:
+        if (swar) blend50(bufA, bufB, PIXELS);
+        else scalarBlend50(bufA, bufB, PIXELS);
+        break;
+    case BLEND_ALPHA:
+        if (swar) blendAlpha(bufA, bufB, 96, PIXELS);
+        else scalarBlendAlpha(bufA, bufB, 96, PIXELS);
+        break;
+    case CONVERT:
+        if (swar) color565Buffer(bufA, rgb, PIXELS);
+        else scalarConvert(bufA, rgb, PIXELS);
+        break;
+    }
+    sink += bufA[PIXELS / 2];
+}
+
+// Nanoseconds per pixel, repeating the kernel for at least MIN_SECONDS
+static double timeKernel(int kernel, int swar) {
+    unsigned long reps = 0;
+    clock_t start = clock();
+    double seconds;
+
+    do {
+        run(kernel, swar);
+        reps++;
+        seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    } while (seconds < MIN_SECONDS);
+
+    return seconds * 1e9 / ((double)reps * PIXELS);
+}
+
+int main(void) {
+    static const char *names[] = { "fill", "copy", "blend50", "blend_alpha", "color565" };
+    unsigned int k;
+
+    if (!check())
+        return 1;
+
+    randomize();
+    printf("kernel,scalar_ns_per_px,swar_ns_per_px,speedup\n");
+    for (k = 0; k < sizeof(names) / sizeof(names[0]); k++) {
+        double scalar = timeKernel(k, 0);
+        double swar = timeKernel(k, 1);
+
+        printf("%s,%.3f,%.3f,%.2f\n", names[k], scalar, swar, scalar / swar);
+    }
+    return 0;
+}
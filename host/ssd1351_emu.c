@@ -0,0 +1,471 @@
+//*****************************************************************************
+//
+// ssd1351_emu.c
+//
+// Byte-level model of the SSD1351 as seen over 4-wire SPI: DC selects
+// command or data, the OC GPIO is the active-low chip select, and every
+// byte is decoded against the command set in Adafruit_SSD1351.h.  Pixels
+// land in a virtual GRAM honouring the column/row window, the address
+// increment mode and the remap, start line and offset registers.
+//
+//*****************************************************************************
+
+#include <string.h>
+
+#include "hw_memmap.h"
+#include "gpio.h"
+#include "spi.h"
+
+#include "Adafruit_SSD1351.h"
+#include "ssd1351_emu.h"
+
+#define DC_PIN      0x8     // GPIOA0
+#define OC_PIN      0x80    // GPIOA3 (GPIOA0 on the Lab2 wiring)
+#define RESET_PIN   0x10    // GPIOA3
+
+#define DEFAULT_REMAP 0x74  // Adafruit_Init() value, taken as "upright"
+
+EmuStats emuStats;
+
+static unsigned short gram[EMU_HEIGHT][EMU_WIDTH];
+
+static int selected;            // OC low
+static int dcHigh;
+static int resetLow;
+
+static int colStart, colEnd, rowStart, rowEnd;
+static int col, row;            // write pointer
+static int remap, startLine, offset;
+static int inverted, locked;
+
+static int cmd = -1;            // command collecting arguments or streaming
+static int argsNeeded, argCount;
+static unsigned char args[64];
+static int pixelHi = -1;        // first byte of a pending RGB565 pixel
+
+static unsigned long rxPending;
+
+static FILE *trace;
+static unsigned long runPixels;     // pixels in the current WRITERAM run
+
+//*****************************************************************************
+// Number of parameter bytes that follow each command; -1 marks a command
+// that is followed by a data stream (WRITERAM/READRAM), -2 an unknown byte.
+//*****************************************************************************
+static int argCountFor(int c) {
+    switch (c) {
+    case SSD1351_CMD_SETCOLUMN:
+    case SSD1351_CMD_SETROW:
+        return 2;
+    case SSD1351_CMD_WRITERAM:
+    case SSD1351_CMD_READRAM:
+        return -1;
+    case SSD1351_CMD_SETREMAP:
+    case SSD1351_CMD_STARTLINE:
+    case SSD1351_CMD_DISPLAYOFFSET:
+    case SSD1351_CMD_FUNCTIONSELECT:
+    case SSD1351_CMD_PRECHARGE:
+    case SSD1351_CMD_CLOCKDIV:
+    case SSD1351_CMD_SETGPIO:
+    case SSD1351_CMD_PRECHARGE2:
+    case SSD1351_CMD_PRECHARGELEVEL:
+    case SSD1351_CMD_VCOMH:
+    case SSD1351_CMD_CONTRASTMASTER:
+    case SSD1351_CMD_MUXRATIO:
+    case SSD1351_CMD_COMMANDLOCK:
+        return 1;
+    case SSD1351_CMD_DISPLAYENHANCE:
+    case SSD1351_CMD_SETVSL:
+    case SSD1351_CMD_CONTRASTABC:
+        return 3;
+    case SSD1351_CMD_HORIZSCROLL:
+        return 5;
+    case SSD1351_CMD_SETGRAY:
+        return 63;
+    case SSD1351_CMD_DISPLAYALLOFF:
+    case SSD1351_CMD_DISPLAYALLON:
+    case SSD1351_CMD_NORMALDISPLAY:
+    case SSD1351_CMD_INVERTDISPLAY:
+    case SSD1351_CMD_DISPLAYOFF:
+    case SSD1351_CMD_DISPLAYON:
+    case SSD1351_CMD_USELUT:
+    case SSD1351_CMD_STOPSCROLL:
+    case SSD1351_CMD_STARTSCROLL:
+        return 0;
+    default:
+        return -2;
+    }
+}
+
+static void resetRegisters(void) {
+    colStart = rowStart = 0;
+    colEnd = EMU_WIDTH - 1;
+    rowEnd = EMU_HEIGHT - 1;
+    col = row = 0;
+    remap = DEFAULT_REMAP;
+    startLine = offset = 0;
+    inverted = locked = 0;
+    cmd = -1;
+    argsNeeded = argCount = 0;
+    pixelHi = -1;
+}
+
+void emuClearStats(void) {
+    memset(&emuStats, 0, sizeof(emuStats));
+}
+
+void emuReset(void) {
+    memset(gram, 0, sizeof(gram));
+    resetRegisters();
+    selected = dcHigh = resetLow = 0;
+    rxPending = 0;
+    runPixels = 0;
+    emuClearStats();
+}
+
+void emuTrace(FILE *f) {
+    trace = f;
+}
+
+static void endRun(void) {
+    if (trace && runPixels)
+        fprintf(trace, "    pixels %lu\n", runPixels);
+    runPixels = 0;
+}
+
+static void traceCommand(void) {
+    int i;
+
+    if (!trace)
+        return;
+    fprintf(trace, "  cmd %02X", cmd);
+    for (i = 0; i < argCount; i++)
+        fprintf(trace, " %02X", args[i]);
+    fputc('\n', trace);
+}
+
+static int clamp(int v, int max) {
+    return v > max ? max : v;
+}
+
+static void apply(void) {
+    traceCommand();
+
+    switch (cmd) {
+    case SSD1351_CMD_SETCOLUMN:
+        colStart = clamp(args[0], EMU_WIDTH - 1);
+        colEnd = clamp(args[1], EMU_WIDTH - 1);
+        col = colStart;
+        break;
+    case SSD1351_CMD_SETROW:
+        rowStart = clamp(args[0], EMU_HEIGHT - 1);
+        rowEnd = clamp(args[1], EMU_HEIGHT - 1);
+        row = rowStart;
+        break;
+    case SSD1351_CMD_SETREMAP:
+        remap = args[0];
+        break;
+    case SSD1351_CMD_STARTLINE:
+        startLine = args[0] & (EMU_HEIGHT - 1);
+        break;
+    case SSD1351_CMD_DISPLAYOFFSET:
+        offset = args[0] & (EMU_HEIGHT - 1);
+        break;
+    case SSD1351_CMD_COMMANDLOCK:
+        if (args[0] == 0x16) locked = 1;
+        if (args[0] == 0x12) locked = 0;
+        break;
+    case SSD1351_CMD_NORMALDISPLAY:
+        inverted = 0;
+        break;
+    case SSD1351_CMD_INVERTDISPLAY:
+        inverted = 1;
+        break;
+    case SSD1351_CMD_WRITERAM:
+        // the write pointer is left where SETCOLUMN/SETROW and earlier
+        // data put it
+        pixelHi = -1;
+        break;
+    default:
+        break;
+    }
+}
+
+static void advance(void) {
+    if (remap & 0x01) {
+        // vertical address increment
+        if (++row > rowEnd) {
+            row = rowStart;
+            if (++col > colEnd)
+                col = colStart;
+        }
+    } else {
+        if (++col > colEnd) {
+            col = colStart;
+            if (++row > rowEnd)
+                row = rowStart;
+        }
+    }
+}
+
+static void commandByte(unsigned char c) {
+    int n = argCountFor(c);
+
+    emuStats.commands++;
+
+    // Adafruit_Init() sends a few parameters with DC low; accept a byte
+    // that is not an opcode as the parameter of a command still waiting
+    if (argCount < argsNeeded && n == -2) {
+        args[argCount++] = c;
+        if (argCount == argsNeeded)
+            apply();
+        return;
+    }
+
+    endRun();
+    emuStats.opcodes[c]++;
+    cmd = c;
+    argCount = 0;
+    argsNeeded = n > 0 ? n : 0;
+    pixelHi = -1;
+    if (n == 0 || n == -1)
+        apply();
+}
+
+static void dataByte(unsigned char d) {
+    emuStats.dataBytes++;
+
+    if (cmd == SSD1351_CMD_WRITERAM) {
+        if (pixelHi < 0) {
+            pixelHi = d;
+            return;
+        }
+        gram[row][col] = (pixelHi << 8) | d;
+        pixelHi = -1;
+        emuStats.pixels++;
+        runPixels++;
+        advance();
+    } else if (argCount < argsNeeded) {
+        args[argCount++] = d;
+        if (argCount == argsNeeded)
+            apply();
+    }
+}
+
+unsigned int emuGram(int c, int r) {
+    return gram[r][c];
+}
+
+unsigned int emuPixel(int x, int y) {
+    int com, c, r;
+    unsigned int p;
+
+    // SEG remap (bit 1) mirrors columns, COM scan direction (bit 4) mirrors
+    // lines; both relative to the 0x74 the driver treats as upright
+    c = (remap & 0x02) ? EMU_WIDTH - 1 - x : x;
+    com = (remap & 0x10) ? y : EMU_HEIGHT - 1 - y;
+    r = (com + startLine + EMU_HEIGHT - offset) % EMU_HEIGHT;
+
+    p = gram[r][c];
+    if ((remap ^ DEFAULT_REMAP) & 0x04)
+        p = ((p & 0x1F) << 11) | (p & 0x07E0) | (p >> 11);
+    if (inverted)
+        p ^= 0xFFFF;
+    return p;
+}
+
+int emuWritePPM(const char *path) {
+    FILE *f = fopen(path, "wb");
+    int x, y;
+
+    if (!f)
+        return -1;
+
+    fprintf(f, "P6\n%d %d\n255\n", EMU_WIDTH, EMU_HEIGHT);
+    for (y = 0; y < EMU_HEIGHT; y++) {
+        for (x = 0; x < EMU_WIDTH; x++) {
+            unsigned int p = emuPixel(x, y);
+            unsigned char rgb[3];
+
+            rgb[0] = ((p >> 11) & 0x1F) * 255 / 31;
+            rgb[1] = ((p >> 5) & 0x3F) * 255 / 63;
+            rgb[2] = (p & 0x1F) * 255 / 31;
+            fwrite(rgb, 1, 3, f);
+        }
+    }
+    return fclose(f) ? -1 : 0;
+}
+
+//*****************************************************************************
+// PNG output without zlib: the image data is wrapped in stored (type 0)
+// deflate blocks, so only the CRC-32 and Adler-32 checksums are needed.
+//*****************************************************************************
+static unsigned long crcTable[256];
+
+static unsigned long crc32(unsigned long crc, const unsigned char *p, int n) {
+    int i, k;
+
+    if (!crcTable[1]) {
+        for (i = 0; i < 256; i++) {
+            unsigned long c = i;
+            for (k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320UL ^ (c >> 1) : c >> 1;
+            crcTable[i] = c;
+        }
+    }
+    crc ^= 0xFFFFFFFFUL;
+    while (n--)
+        crc = crcTable[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFUL;
+}
+
+static void put32(unsigned char *p, unsigned long v) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static void writeChunk(FILE *f, const char *type, const unsigned char *data, int n) {
+    unsigned char hdr[8];
+    unsigned long crc;
+
+    put32(hdr, n);
+    memcpy(hdr + 4, type, 4);
+    crc = crc32(0, hdr + 4, 4);
+    crc = crc32(crc, data, n);
+    fwrite(hdr, 1, 8, f);
+    fwrite(data, 1, n, f);
+    put32(hdr, crc);
+    fwrite(hdr, 1, 4, f);
+}
+
+#define PNG_ROW     (1 + 3 * EMU_WIDTH)     // filter byte + RGB
+
+int emuWritePNG(const char *path) {
+    static const unsigned char sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    static unsigned char idat[2 + EMU_HEIGHT * (5 + PNG_ROW) + 4];
+    unsigned char ihdr[13] = { 0 };
+    unsigned long a = 1, b = 0;
+    unsigned char *p = idat;
+    FILE *f = fopen(path, "wb");
+    int x, y, i;
+
+    if (!f)
+        return -1;
+
+    put32(ihdr, EMU_WIDTH);
+    put32(ihdr + 4, EMU_HEIGHT);
+    ihdr[8] = 8;                    // bit depth
+    ihdr[9] = 2;                    // truecolour
+
+    // zlib header, then one stored block per image row
+    *p++ = 0x78;
+    *p++ = 0x01;
+    for (y = 0; y < EMU_HEIGHT; y++) {
+        unsigned char *row;
+
+        *p++ = y == EMU_HEIGHT - 1;  // BFINAL on the last block
+        *p++ = PNG_ROW & 0xFF;
+        *p++ = PNG_ROW >> 8;
+        *p++ = ~PNG_ROW & 0xFF;
+        *p++ = (~PNG_ROW >> 8) & 0xFF;
+
+        row = p;
+        *p++ = 0;                   // no filter
+        for (x = 0; x < EMU_WIDTH; x++) {
+            unsigned int c = emuPixel(x, y);
+
+            *p++ = ((c >> 11) & 0x1F) * 255 / 31;
+            *p++ = ((c >> 5) & 0x3F) * 255 / 63;
+            *p++ = (c & 0x1F) * 255 / 31;
+        }
+        for (i = 0; i < PNG_ROW; i++) {
+            a = (a + row[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+    }
+    put32(p, (b << 16) | a);
+    p += 4;
+
+    fwrite(sig, 1, 8, f);
+    writeChunk(f, "IHDR", ihdr, 13);
+    writeChunk(f, "IDAT", idat, p - idat);
+    writeChunk(f, "IEND", NULL, 0);
+    return fclose(f) ? -1 : 0;
+}
+
+//*****************************************************************************
+//
+// Driverlib shims
+//
+//*****************************************************************************
+
+void GPIOPinWrite(unsigned long ulPort, unsigned char ucPins, unsigned char ucVal) {
+    if (ulPort == GPIOA0_BASE && (ucPins & DC_PIN)) {
+        int level = (ucVal & DC_PIN) != 0;
+
+        if (level != dcHigh)
+            emuStats.dcToggles++;
+        dcHigh = level;
+    }
+
+    if ((ulPort == GPIOA0_BASE || ulPort == GPIOA3_BASE) && (ucPins & OC_PIN)) {
+        int sel = (ucVal & OC_PIN) == 0;
+
+        if (sel && !selected) {
+            emuStats.csToggles++;
+            if (trace)
+                fprintf(trace, "select\n");
+        } else if (!sel && selected) {
+            endRun();
+        }
+        selected = sel;
+    }
+
+    if (ulPort == GPIOA3_BASE && (ucPins & RESET_PIN)) {
+        int low = (ucVal & RESET_PIN) == 0;
+
+        if (low && !resetLow)
+            resetRegisters();
+        resetLow = low;
+    }
+}
+
+void SPIDataPut(unsigned long ulBase, unsigned long ulData) {
+    (void)ulBase;
+    rxPending++;
+
+    if (!selected || resetLow) {
+        emuStats.ignoredBytes++;
+        return;
+    }
+    if (dcHigh)
+        dataByte(ulData & 0xFF);
+    else
+        commandByte(ulData & 0xFF);
+}
+
+void SPIDataGet(unsigned long ulBase, unsigned long *pulData) {
+    (void)ulBase;
+    if (rxPending)
+        rxPending--;
+    *pulData = 0;
+}
+
+long SPIDataGetNonBlocking(unsigned long ulBase, unsigned long *pulData) {
+    (void)ulBase;
+    if (!rxPending)
+        return 0;
+    rxPending--;
+    *pulData = 0;
+    return 1;
+}
+
+void SPICSEnable(unsigned long ulBase) {
+    (void)ulBase;
+}
+
+void SPICSDisable(unsigned long ulBase) {
+    (void)ulBase;
+}
@@ -0,0 +1,51 @@
+//*****************************************************************************
+//
+// ssd1351_emu.h
+//
+// Host-side model of the SSD1351 controller.  The driverlib stubs in
+// include/ route SPIDataPut() and GPIOPinWrite() here, so the unmodified
+// Adafruit_OLED.c / Adafruit_GFX.c sources drive a virtual panel.
+//
+//*****************************************************************************
+
+#ifndef _SSD1351_EMU_H
+#define _SSD1351_EMU_H
+
+#include <stdio.h>
+
+#define EMU_WIDTH   128
+#define EMU_HEIGHT  128
+
+typedef struct {
+    unsigned long commands;         // bytes received with DC low
+    unsigned long dataBytes;        // bytes received with DC high
+    unsigned long csToggles;        // chip select assertions
+    unsigned long dcToggles;        // DC level changes
+    unsigned long pixels;           // complete pixels written to GRAM
+    unsigned long ignoredBytes;     // bytes clocked out while deselected
+    unsigned long opcodes[256];     // per-command histogram
+} EmuStats;
+
+extern EmuStats emuStats;
+
+// Power-on state: GRAM cleared, full window, default registers, counters zeroed
+void emuReset(void);
+void emuClearStats(void);
+
+// Log every transaction to f (NULL turns tracing off).  One line per
+// chip select, command with its parameters, and WRITERAM pixel run.
+void emuTrace(FILE *f);
+
+// Raw controller RAM, as addressed by SETCOLUMN/SETROW
+unsigned int emuGram(int col, int row);
+
+// Pixel as it appears on the glass at (x, y)
+unsigned int emuPixel(int x, int y);
+
+// Write what the glass shows as a binary PPM; returns 0 on success
+int emuWritePPM(const char *path);
+
+// Same, as an uncompressed PNG
+int emuWritePNG(const char *path);
+
+#endif // _SSD1351_EMU_H
@@ -0,0 +1,160 @@
+//*****************************************************************************
+//
+// timer_emu.c
+//
+// Timer A counts down from its 24-bit start value (prescaler above load)
+// and reloads on reaching zero, raising the timeout; an edge latches the
+// count and raises the capture event.  Only the one timer configured for
+// capture is modelled.
+//
+//*****************************************************************************
+
+#include "hw_types.h"
+#include "timer.h"
+
+#include "timer_emu.h"
+
+TimerEmuStats timerEmuStats;
+
+static unsigned long base;
+static unsigned long prescale, load;
+static unsigned long enabled;       // interrupt sources
+static unsigned long status;        // raw interrupt status
+static unsigned long latched;       // count at the last capture
+static int running;
+static void (*handler)(void);
+
+static unsigned long latency;
+static unsigned long long nextReload;
+
+static unsigned long long period(void) {
+    return ((unsigned long long)(prescale << 16 | load)) + 1;
+}
+
+static void interrupt(void) {
+    if (handler && (status & enabled))
+        handler();
+}
+
+static void reload(void) {
+    status |= TIMER_TIMA_TIMEOUT;
+    nextReload += period();
+    timerEmuStats.timeouts++;
+}
+
+//*****************************************************************************
+// Model
+//*****************************************************************************
+
+void timerEmuReset(void) {
+    base = 0;
+    prescale = load = 0;
+    enabled = status = latched = 0;
+    running = 0;
+    handler = 0;
+    timerEmuStats.captures = 0;
+    timerEmuStats.timeouts = 0;
+    timerEmuStats.shared = 0;
+}
+
+void timerEmuLatency(unsigned long ticks) {
+    latency = ticks;
+}
+
+void timerEmuRun(unsigned long long t) {
+    if (!running)
+        return;
+    while (nextReload <= t) {
+        reload();
+        interrupt();
+    }
+}
+
+void timerEmuEdge(unsigned long long t) {
+    if (!running)
+        return;
+
+    // reloads whose handler ran before the edge came
+    while (nextReload + latency <= t) {
+        reload();
+        interrupt();
+    }
+
+    // a reload just before the edge, or one before its handler gets going
+    if (nextReload <= t + latency)
+        reload();
+
+    latched = (prescale << 16 | load) - (unsigned long)(t % period());
+    status |= TIMER_CAPA_EVENT;
+    timerEmuStats.captures++;
+    if (status & TIMER_TIMA_TIMEOUT)
+        timerEmuStats.shared++;
+    interrupt();
+}
+
+//*****************************************************************************
+// Driverlib
+//*****************************************************************************
+
+void TimerConfigure(unsigned long ulBase, unsigned long ulConfig) {
+    (void)ulConfig;
+    base = ulBase;
+    running = 0;
+}
+
+void TimerControlEvent(unsigned long ulBase, unsigned long ulTimer,
+                       unsigned long ulEvent) {
+    (void)ulBase;
+    (void)ulTimer;
+    (void)ulEvent;
+}
+
+void TimerPrescaleSet(unsigned long ulBase, unsigned long ulTimer,
+                      unsigned long ulValue) {
+    (void)ulTimer;
+    if (ulBase == base)
+        prescale = ulValue & 0xFF;
+}
+
+void TimerLoadSet(unsigned long ulBase, unsigned long ulTimer,
+                  unsigned long ulValue) {
+    (void)ulTimer;
+    if (ulBase == base)
+        load = ulValue & 0xFFFF;
+}
+
+void TimerIntRegister(unsigned long ulBase, unsigned long ulTimer,
+                      void (*pfnHandler)(void)) {
+    (void)ulTimer;
+    if (ulBase == base)
+        handler = pfnHandler;
+}
+
+void TimerIntEnable(unsigned long ulBase, unsigned long ulIntFlags) {
+    if (ulBase == base)
+        enabled |= ulIntFlags;
+}
+
+unsigned long TimerIntStatus(unsigned long ulBase, int bMasked) {
+    if (ulBase != base)
+        return 0;
+    return bMasked ? status & enabled : status;
+}
+
+void TimerIntClear(unsigned long ulBase, unsigned long ulIntFlags) {
+    if (ulBase == base)
+        status &= ~ulIntFlags;
+}
+
+unsigned long TimerValueGet(unsigned long ulBase, unsigned long ulTimer) {
+    (void)ulTimer;
+    return ulBase == base ? latched : 0;
+}
+
+void TimerEnable(unsigned long ulBase, unsigned long ulTimer) {
+    (void)ulTimer;
+    if (ulBase != base)
+        return;
+    running = 1;
+    nextReload = period();
+}
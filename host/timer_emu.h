@@ -0,0 +1,45 @@
+//*****************************************************************************
+//
+// timer_emu.h
+//
+// Host-side model of timer A of a CC3200 general purpose timer in
+// edge-time capture mode, as ircapture.c sets it up.  The driverlib stubs
+// in include/ route the Timer* calls here; the host then plays edges on
+// the capture pin and the registered handler runs for each one, and for
+// every reload in between, just as the interrupt would on the board.
+//
+// Time is counted in timer ticks from TimerEnable().  The handler for an
+// event runs a fixed latency after it, so a reload and an edge that fall
+// within that latency of each other are both pending when it does.
+//
+//*****************************************************************************
+
+#ifndef _TIMER_EMU_H
+#define _TIMER_EMU_H
+
+#define EMU_TIMER_HZ    80000000UL
+
+typedef struct {
+    unsigned long captures;     // edges latched
+    unsigned long timeouts;     // reloads
+    unsigned long shared;       // handler calls that found both pending
+} TimerEmuStats;
+
+extern TimerEmuStats timerEmuStats;
+
+// Stop the timer, forget the handler and zero the counters
+void timerEmuReset(void);
+
+// Ticks from an event to its handler running (default 0).  Keep it below
+// the shortest pulse: by then the real timer would have latched the next
+// edge over the last one, which is not modelled.
+void timerEmuLatency(unsigned long ticks);
+
+// An edge on the capture pin at tick t; t never goes backwards.  Reloads
+// due before it are handled first.
+void timerEmuEdge(unsigned long long t);
+
+// Run the clock to tick t without an edge
+void timerEmuRun(unsigned long long t);
+
+#endif // _TIMER_EMU_H